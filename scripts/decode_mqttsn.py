@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+#
+# Decode binary MQTT-SN publications (CONFIG_MQTT_SNCLIENT_PAYLOAD_BINARY)
+# into the same JSON object the firmware publishes in JSON mode.
+#
+# With --delta, decode CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA publications
+# instead, or with --lorawan, LoRaWAN uplinks given as hex FRMPayload.
+# Both are delta records each preceded by its age, the state is kept per
+# topic or device. Version 4 LoRaWAN uplinks, a single record without an
+# age, decode with --lorawan-v4.
+#
+# Usage:
+#   decode_mqttsn.py [--delta|--lorawan|--lorawan-v4] <hex payload> [<topic>]
+#   mosquitto_sub -t 'ot/#' -F '%t %x' | decode_mqttsn.py [--delta]
+#
+
+import json
+import struct
+import sys
+
+# Little-endian layout, see mqttsnEncodeBatch() in src/mqttsn.c
+#
+# Header
+#  0     uint8   version
+#  1..2  uint16  sequence number of the first sample
+#  3..4  uint16  RLOC16
+#  5     uint8   Thread role (otDeviceRole)
+#  6     uint8   triage status (P0..P3)
+#  7     uint8   battery %
+#  8     uint8   number of samples
+#
+# Followed by one record per sample, oldest first
+#  0..1  uint16  age at publication, s
+#  2     uint8   flags, bit0 GPS lock
+#  3..6  int32   latitude, 1e-7 degrees
+#  7..10 int32   longitude, 1e-7 degrees
+# 11..12 int16   elevation, m
+# 13..14 uint16  speed, cm/s
+# 15..16 int16   temperature, 1/100 degrees C
+HEADER = struct.Struct("<BHHBBBB")
+SAMPLE = struct.Struct("<HBiihHh")
+
+ROLES = ["disabled", "detached", "child", "router", "leader"]
+
+# Delta records, see src/delta.h
+#  0     uint8   bit7 keyframe, bits 0..6 version
+#  1..2  uint16  sequence number
+#  3     uint8   field mask
+# Followed by the fields set in the mask, in bit order
+DELTA_HEADER = struct.Struct("<BHB")
+DELTA_KEYFRAME = 0x80
+DELTA_FIELDS = [
+    ("status", struct.Struct("<B")),
+    ("battery", struct.Struct("<B")),
+    ("rloc16", struct.Struct("<H")),
+    ("flags", struct.Struct("<B")),
+    ("position", struct.Struct("<ii")),
+    ("elevation", struct.Struct("<h")),
+    ("speed", struct.Struct("<H")),
+    ("temperature", struct.Struct("<h")),
+]
+AGE = struct.Struct("<H")
+
+
+class DeltaState:
+    """Fields rebuilt from the delta records of one device"""
+
+    def __init__(self):
+        self.fields = None
+        self.seq = None
+        self.lost = 0
+
+    def apply(self, payload, offset):
+        if len(payload) < offset + DELTA_HEADER.size:
+            raise ValueError("truncated delta record at byte %d" % offset)
+        version, seq, mask = DELTA_HEADER.unpack_from(payload, offset)
+        offset += DELTA_HEADER.size
+
+        fields = {}
+        for bit, (name, field) in enumerate(DELTA_FIELDS):
+            if mask & (1 << bit):
+                if len(payload) < offset + field.size:
+                    raise ValueError("truncated %s field at byte %d" % (name, offset))
+                value = field.unpack_from(payload, offset)
+                fields[name] = value if len(value) > 1 else value[0]
+                offset += field.size
+
+        if self.seq is not None and seq != (self.seq + 1) & 0xFFFF:
+            self.lost += (seq - self.seq - 1) & 0xFFFF
+            if not version & DELTA_KEYFRAME:
+                # Fields changed in the lost records are unknown until the
+                # next keyframe
+                self.fields = None
+        self.seq = seq
+
+        if version & DELTA_KEYFRAME:
+            self.fields = fields
+        elif self.fields is not None:
+            self.fields.update(fields)
+
+        return version & ~DELTA_KEYFRAME, offset
+
+    def sample(self):
+        if self.fields is None:
+            return None
+        f = self.fields
+        return {
+            "Count": self.seq,
+            "Role": ROLES[f["status"] & 0x0f] if (f["status"] & 0x0f) < len(ROLES) else str(f["status"] & 0x0f),
+            "Status": "P%d" % (f["status"] >> 4),
+            "Battery": f["battery"],
+            "RLOC16": "%04X" % f["rloc16"],
+            "GPSLock": f["flags"] & 0x01,
+            "Latitude": f["position"][0],
+            "Longitude": f["position"][1],
+            "Elevation": f["elevation"],
+            "Speed": f["speed"],
+            "Temperature": f["temperature"] / 100,
+            "Lost": self.lost,
+        }
+
+
+_states = {}
+
+
+def decode_delta(payload, topic=None, ages=True):
+    state = _states.setdefault(topic, DeltaState())
+    message = {}
+    if topic:
+        message["ID"] = topic.rstrip("/").split("/")[-1]
+    message["Samples"] = []
+
+    offset = 0
+    while offset < len(payload):
+        age = None
+        if ages:
+            if len(payload) < offset + AGE.size:
+                raise ValueError("truncated age at byte %d" % offset)
+            (age,) = AGE.unpack_from(payload, offset)
+            offset += AGE.size
+        version, offset = state.apply(payload, offset)
+        message["Version"] = str(version)
+
+        sample = state.sample()
+        if sample is None:
+            # Waiting for a keyframe
+            continue
+        if age is not None:
+            sample["Age"] = age
+        message["Samples"].append(sample)
+    return message
+
+
+def decode(payload, topic=None):
+    if len(payload) < HEADER.size:
+        raise ValueError("expected at least %d bytes, got %d" % (HEADER.size, len(payload)))
+
+    version, seq, rloc16, role, status, battery, count = HEADER.unpack_from(payload)
+
+    if len(payload) != HEADER.size + count * SAMPLE.size:
+        raise ValueError("expected %d bytes for %d samples, got %d" %
+                         (HEADER.size + count * SAMPLE.size, count, len(payload)))
+
+    message = {}
+    if topic:
+        # The ID is the last topic level, e.g. ot/f4ce361832e86d55
+        message["ID"] = topic.rstrip("/").split("/")[-1]
+    message.update({
+        "RLOC16": "%04X" % rloc16,
+        "Version": str(version),
+        "Count": seq,
+        "Role": ROLES[role] if role < len(ROLES) else str(role),
+        "Status": "P%d" % status,
+        "Battery": battery,
+        "Samples": [],
+    })
+
+    for i in range(count):
+        (age, flags, latitude, longitude, elevation, speed,
+         temperature) = SAMPLE.unpack_from(payload, HEADER.size + i * SAMPLE.size)
+        message["Samples"].append({
+            "Age": age,
+            "GPSLock": flags & 0x01,
+            "Latitude": latitude,
+            "Longitude": longitude,
+            "Elevation": elevation,
+            "Speed": speed,
+            "Temperature": temperature / 100,
+        })
+    return message
+
+
+def main():
+    args = sys.argv[1:]
+    decoder = decode
+    if args and args[0] == "--delta":
+        decoder = decode_delta
+        args = args[1:]
+    elif args and args[0] == "--lorawan":
+        decoder = decode_delta
+        args = args[1:]
+    elif args and args[0] == "--lorawan-v4":
+        decoder = lambda payload, topic: decode_delta(payload, topic, ages=False)
+        args = args[1:]
+
+    if args:
+        topic = args[1] if len(args) > 1 else None
+        print(json.dumps(decoder(bytes.fromhex(args[0]), topic)))
+        return
+
+    for line in sys.stdin:
+        fields = line.split()
+        if not fields:
+            continue
+        topic, data = (fields[0], fields[1]) if len(fields) > 1 else (None, fields[0])
+        try:
+            print(json.dumps(decoder(bytes.fromhex(data), topic)), flush=True)
+        except ValueError as e:
+            print("%s: %s" % (topic or "-", e), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
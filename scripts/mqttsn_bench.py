@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+#
+# Benchmark MQTT-SN publication throughput and latency against the gateway
+# stand-in, mqttsn_gateway.py, under induced datagram loss.
+#
+# The client publishes samples as fast as its in-flight window allows, the
+# way the publisher in src/mqttsn.c does:
+#   - up to --window QoS1 publications awaiting a PUBACK, each with its own
+#     message ID, resent with the DUP flag after --timeout seconds, --retries
+#     times
+#   - samples released in publishing order as publications complete; one
+#     acknowledged behind an older one leaves the window but keeps its entry,
+#     out of --table entries, until the older one completes
+#   - a publication that runs out of retries sends everything from the
+#     oldest unreleased sample again, go-back-N
+#   - with --qos 0 telemetry goes at QoS0 and only every --state-every th
+#     publication, a state change, at QoS1
+#
+# One publication carries one sample, a JSON payload with its sequence
+# number in "Count". The gateway's output is read back to count the samples
+# that reached it.
+#
+# For every window size, loss rate and QoS it prints publications sent per
+# second, distinct samples delivered per second, resends, go-back-N resets
+# and the time from first sending a sample to its PUBACK.
+#
+# Localhost answers in well under a millisecond, so every datagram the
+# client sends is held back for --rtt seconds to stand in for the mesh. The
+# firmware retransmits after 10 s, about a hundred round trips of a few
+# hops; --timeout and --rtt keep that ratio by default but run faster.
+#
+# Usage:
+#   mqttsn_bench.py [--windows 1,2,4,8] [--loss 0,0.05,0.2] [--qos 1] ...
+#
+
+import argparse
+import json
+import os
+import select
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+CONNECT = 0x04
+CONNACK = 0x05
+REGISTER = 0x0A
+REGACK = 0x0B
+PUBLISH = 0x0C
+PUBACK = 0x0D
+
+RC_ACCEPTED = 0x00
+FLAG_DUP = 0x80
+FLAG_QOS1 = 0x20
+
+TOPIC = "ot/bench"
+
+
+def packet(msg_type, body=b""):
+    return struct.pack(">BB", len(body) + 2, msg_type) + body
+
+
+def percentile(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+class Publication:
+    def __init__(self, msg_id, seq, qos, now):
+        self.msg_id = msg_id
+        self.seq = seq
+        self.qos = qos
+        self.sent = now
+        self.retries = 0
+        self.acked = qos == 0
+
+
+class Publisher:
+    def __init__(self, sock, topic_id, args, window, qos):
+        self.sock = sock
+        self.topic_id = topic_id
+        self.args = args
+        self.window = window
+        self.qos = qos
+        self.inflight = []          # Publications, oldest first
+        self.released = 0           # Samples before this one are done
+        self.next_seq = 0
+        self.msg_id = 0
+        self.first_sent = {}        # seq -> time first sent
+        self.latency = []
+        self.sent = 0
+        self.resends = 0
+        self.resets = 0
+        self.outbox = []            # (due, datagram), held back for the round trip
+
+    def send(self, publication, dup=False):
+        flags = (FLAG_QOS1 if publication.qos else 0) | (FLAG_DUP if dup else 0)
+        payload = json.dumps({"Count": publication.seq, "Samples": [{"Age": 0}]}).encode()
+        data = packet(PUBLISH, struct.pack(">BHH", flags, self.topic_id, publication.msg_id) + payload)
+        self.outbox.append((time.monotonic() + self.args.rtt, data))
+        self.sent += 1
+
+    def flush(self, now):
+        while self.outbox and self.outbox[0][0] <= now:
+            self.sock.send(self.outbox.pop(0)[1])
+
+    def unacked(self):
+        return sum(1 for publication in self.inflight if not publication.acked)
+
+    def fill(self, now):
+        while self.unacked() < self.window and len(self.inflight) < self.args.table:
+            seq = self.next_seq
+            state = seq % self.args.state_every == 0
+            self.msg_id = self.msg_id % 0xFFFF + 1
+            publication = Publication(self.msg_id, seq, 1 if self.qos or state else 0, now)
+            self.first_sent.setdefault(seq, now)
+            self.send(publication)
+            self.inflight.append(publication)
+            self.next_seq += 1
+            self.release()
+
+    def release(self):
+        while self.inflight and self.inflight[0].acked:
+            publication = self.inflight.pop(0)
+            self.released = publication.seq + 1
+            self.first_sent.pop(publication.seq, None)
+
+    def acked(self, msg_id, code, now):
+        for publication in self.inflight:
+            if publication.msg_id == msg_id and not publication.acked:
+                if code != RC_ACCEPTED:
+                    self.reset()
+                    return
+                publication.acked = True
+                self.latency.append(now - self.first_sent[publication.seq])
+                self.release()
+                return
+        # Late PUBACKs of publications given up on match nothing
+
+    def reset(self):
+        self.resets += 1
+        self.inflight = []
+        self.next_seq = self.released
+
+    def expire(self, now):
+        for publication in self.inflight:
+            if publication.acked or now - publication.sent < self.args.timeout:
+                continue
+            if publication.retries >= self.args.retries:
+                self.reset()
+                return
+            publication.retries += 1
+            publication.sent = now
+            self.resends += 1
+            self.send(publication, dup=True)
+
+    def deadline(self):
+        pending = [p.sent + self.args.timeout for p in self.inflight if not p.acked]
+        if self.outbox:
+            pending.append(self.outbox[0][0])
+        return min(pending) if pending else None
+
+
+def free_port():
+    probe = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    probe.bind(("::1", 0))
+    port = probe.getsockname()[1]
+    probe.close()
+    return port
+
+
+def session(sock):
+    sock.settimeout(1)
+    for _ in range(20):
+        try:
+            sock.send(packet(CONNECT, struct.pack(">BBH", 0x04, 0x01, 60) + b"ot-bench"))
+            data = sock.recv(1280)
+            if data[1] == CONNACK and data[2] == RC_ACCEPTED:
+                break
+        except (socket.timeout, ConnectionRefusedError):
+            time.sleep(0.1)
+    else:
+        raise RuntimeError("no CONNACK from the gateway")
+
+    for msg_id in range(1, 21):
+        try:
+            sock.send(packet(REGISTER, struct.pack(">HH", 0, msg_id) + TOPIC.encode()))
+            data = sock.recv(1280)
+            if data[1] == REGACK:
+                return struct.unpack_from(">H", data, 2)[0]
+        except socket.timeout:
+            pass
+    raise RuntimeError("no REGACK from the gateway")
+
+
+def run(args, window, loss, qos):
+    port = free_port()
+    here = os.path.dirname(os.path.abspath(__file__))
+    # Publications go to a file, a pipe would fill up and stall the gateway
+    publications = tempfile.TemporaryFile("w+")
+    gateway = subprocess.Popen([sys.executable, os.path.join(here, "mqttsn_gateway.py"), "--port", str(port),
+                                "--multicast", "", "--report", "3600", "--loss", str(loss),
+                                "--seed", str(args.seed)],
+                               stdout=publications, stderr=subprocess.DEVNULL, text=True)
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    try:
+        sock.connect(("::1", port))
+        topic_id = session(sock)
+        sock.setblocking(False)
+
+        publisher = Publisher(sock, topic_id, args, window, qos)
+        start = time.monotonic()
+        end = start + args.duration
+        now = start
+        while now < end:
+            publisher.fill(now)
+            publisher.flush(now)
+            deadline = publisher.deadline()
+            wait = min(end, deadline) - now if deadline else end - now
+            readable, _, _ = select.select([sock], [], [], max(0.0, min(wait, 0.05)))
+            now = time.monotonic()
+            if readable:
+                try:
+                    data = sock.recv(1280)
+                except (BlockingIOError, ConnectionRefusedError):
+                    continue
+                if len(data) >= 7 and data[1] == PUBACK:
+                    _, msg_id, code = struct.unpack_from(">HHB", data, 2)
+                    publisher.acked(msg_id, code, now)
+            publisher.expire(now)
+        elapsed = now - start
+    finally:
+        sock.close()
+        gateway.send_signal(signal.SIGINT)
+        gateway.wait(timeout=10)
+
+    delivered = set()
+    publications.seek(0)
+    for line in publications:
+        topic, payload = line.split(" ", 1)
+        delivered.add(json.loads(bytes.fromhex(payload))["Count"])
+
+    return {
+        "Window": window,
+        "Loss": loss,
+        "QoS": qos,
+        "SentPerS": publisher.sent / elapsed,
+        "DeliveredPerS": len(delivered) / elapsed,
+        "Resends": publisher.resends,
+        "Resets": publisher.resets,
+        "LatencyP50": percentile(publisher.latency, 50),
+        "LatencyP95": percentile(publisher.latency, 95),
+        "LatencyMax": max(publisher.latency) if publisher.latency else None,
+    }
+
+
+def ms(value):
+    return "%.1f" % (value * 1000) if value is not None else "-"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="MQTT-SN publication benchmark against the gateway stand-in")
+    parser.add_argument("--windows", default="1,2,4,8", help="in-flight window sizes, comma separated")
+    parser.add_argument("--loss", default="0,0.05,0.2", help="datagram loss rates, comma separated")
+    parser.add_argument("--qos", default="1", help="telemetry QoS levels, comma separated")
+    parser.add_argument("--state-every", type=int, default=10, help="every Nth publication is QoS1 with --qos 0")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds per run")
+    parser.add_argument("--timeout", type=float, default=1.0, help="retransmission timeout in seconds")
+    parser.add_argument("--rtt", type=float, default=0.01, help="round trip time added to every publication")
+    parser.add_argument("--retries", type=int, default=3, help="retransmissions before giving up")
+    parser.add_argument("--table", type=int, default=32,
+                        help="publications kept until released, CONFIG_TELEMETRY_BUFFER_SAMPLES")
+    parser.add_argument("--seed", type=int, default=18, help="gateway loss random seed")
+    parser.add_argument("--check", action="store_true",
+                        help="fail unless every run delivers, and larger windows deliver more under loss")
+    args = parser.parse_args()
+
+    windows = [int(w) for w in args.windows.split(",")]
+    results = []
+
+    print("%6s %5s %3s %9s %12s %8s %7s %9s %9s %9s" % ("window", "loss", "QoS", "sent/s", "delivered/s",
+                                                      "resends", "resets", "p50 ms", "p95 ms", "max ms"))
+    for qos in [int(q) for q in args.qos.split(",")]:
+        for loss in [float(p) for p in args.loss.split(",")]:
+            for window in windows:
+                result = run(args, window, loss, qos)
+                results.append(result)
+                print("%6d %5.2f %3d %9.1f %12.1f %8d %7d %9s %9s %9s" % (
+                    window, loss, qos, result["SentPerS"], result["DeliveredPerS"], result["Resends"],
+                    result["Resets"], ms(result["LatencyP50"]), ms(result["LatencyP95"]),
+                    ms(result["LatencyMax"])), flush=True)
+
+    if not args.check:
+        return 0
+
+    failures = 0
+    for result in results:
+        if result["DeliveredPerS"] <= 0:
+            print("window %d, loss %.2f, QoS %d: nothing delivered" % (result["Window"], result["Loss"], result["QoS"]))
+            failures += 1
+    for result in results:
+        if result["Loss"] > 0 and result["Window"] == min(windows):
+            for other in results:
+                if (other["Loss"], other["QoS"]) == (result["Loss"], result["QoS"]) and \
+                        other["Window"] > result["Window"] and other["DeliveredPerS"] <= result["DeliveredPerS"]:
+                    print("window %d delivers no more than window %d at loss %.2f" % (
+                        other["Window"], result["Window"], result["Loss"]))
+                    failures += 1
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,422 @@
+#!/usr/bin/env python3
+#
+# Offline MQTT-SN gateway and broker stand-in for soak and load testing.
+#
+# Answers SEARCHGW on the gateway multicast group and terminates CONNECT,
+# REGISTER, SUBSCRIBE, PUBLISH, PINGREQ and DISCONNECT from any number of
+# clients, so nodes can be exercised without a Paho gateway, a broker or
+# internet access. Faults are injected on request:
+#
+#   --loss P               drop each datagram, in either direction, with
+#                          probability P
+#   --outage-every S       go silent for --outage-for seconds every S
+#   --congestion P         reject CONNECT and PUBLISH with "congestion"
+#                          with probability P
+#
+# With --command-every S, every client that subscribed to its command topic
+# is sent the --command texts, then "state", every S seconds. The time until
+# the client's next publication, which "state" triggers at once, is the
+# command latency: how long the mesh and the node take to respond while
+# the other commands run.
+#
+# Every publication is printed to stdout as "<topic> <hex payload>", the
+# input format of decode_mqttsn.py. A summary is printed to stderr every
+# --report seconds and on exit, covering connected clients, publications
+# and duplicates, samples lost to sequence gaps, time to reconnect after
+# an outage, sample age at arrival percentiles, SEARCHGW received in all
+# and in the busiest second, and command latency percentiles.
+#
+# With --events, connections, searches, commands, publications and sleeps
+# are also written to a file as one JSON object per line, stamped with the
+# wall clock, for harnesses such as soak.py to match against what they did
+# to the nodes.
+#
+# Usage:
+#   mqttsn_gateway.py [--payload json|binary|delta] [--loss 0.1] ...
+#   mqttsn_gateway.py --payload delta | decode_mqttsn.py --delta
+#
+
+import argparse
+import json
+import random
+import select
+import socket
+import struct
+import sys
+import time
+
+import decode_mqttsn
+
+SEARCHGW = 0x01
+GWINFO = 0x02
+CONNECT = 0x04
+CONNACK = 0x05
+REGISTER = 0x0A
+REGACK = 0x0B
+PUBLISH = 0x0C
+PUBACK = 0x0D
+SUBSCRIBE = 0x12
+SUBACK = 0x13
+PINGREQ = 0x16
+PINGRESP = 0x17
+DISCONNECT = 0x18
+
+RC_ACCEPTED = 0x00
+RC_CONGESTION = 0x01
+RC_INVALID_TOPIC = 0x02
+
+TOPIC_NORMAL = 0x00
+TOPIC_PREDEFINED = 0x01
+TOPIC_SHORT = 0x02
+
+FLAG_DUP = 0x80
+
+
+def packet(msg_type, body=b""):
+    length = len(body) + 2
+    if length > 255:
+        return struct.pack(">BHB", 0x01, length + 2, msg_type) + body
+    return struct.pack(">BB", length, msg_type) + body
+
+
+def parse(data):
+    if len(data) >= 4 and data[0] == 0x01:
+        length, msg_type = struct.unpack_from(">HB", data, 1)
+        return msg_type, data[4:length]
+    if len(data) >= 2:
+        return data[1], data[2:data[0]]
+    raise ValueError("short datagram")
+
+
+def percentile(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+class Client:
+    def __init__(self, client_id):
+        self.client_id = client_id
+        self.address = None
+        self.connects = 0
+        self.asleep = False
+        self.last_seen = 0.0
+        self.next_seq = None
+        self.lost = 0
+        self.command_topic = None   # (topic type, 2 byte topic field)
+        self.probe_sent = None
+
+
+class Gateway:
+    def __init__(self, args):
+        self.args = args
+        self.topics = {}            # topic name -> ID
+        self.topic_names = {}       # ID -> topic name
+        self.clients = {}           # client ID -> Client
+        self.by_address = {}        # address -> Client
+        self.publishes = 0
+        self.duplicates = 0
+        self.dropped = 0
+        self.rejected = 0
+        self.ages = []
+        self.reconnects = []
+        self.searches = 0
+        self.search_second = None
+        self.search_count = 0
+        self.search_peak = 0
+        self.commands = 0
+        self.command_latency = []
+        self.unanswered = 0
+        self.outage_until = 0.0
+        self.outage_end = None
+        self.events = open(args.events, "a", buffering=1) if args.events else None
+        self.next_outage = time.monotonic() + args.outage_every if args.outage_every else None
+        self.next_command = time.monotonic() + args.command_every if args.command_every else None
+
+        self.sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind(("::", args.port))
+        if args.multicast:
+            group = socket.inet_pton(socket.AF_INET6, args.multicast)
+            index = socket.if_nametoindex(args.interface) if args.interface else 0
+            self.sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_JOIN_GROUP,
+                                 group + struct.pack("@I", index))
+
+    # Faults
+
+    def in_outage(self, now):
+        if self.next_outage is not None and now >= self.next_outage:
+            self.outage_until = now + self.args.outage_for
+            self.next_outage = now + self.args.outage_every
+            log("outage for %d s" % self.args.outage_for)
+        if self.outage_until and now >= self.outage_until:
+            self.outage_until = 0.0
+            self.outage_end = now
+            log("outage over")
+        return bool(self.outage_until)
+
+    def lose(self):
+        if random.random() < self.args.loss:
+            self.dropped += 1
+            return True
+        return False
+
+    def congested(self):
+        if random.random() < self.args.congestion:
+            self.rejected += 1
+            return True
+        return False
+
+    def send(self, address, msg_type, body=b""):
+        if not self.lose():
+            self.sock.sendto(packet(msg_type, body), address)
+
+    def event(self, name, client, **fields):
+        if self.events:
+            fields.update({"Time": time.time(), "Event": name, "Client": client.client_id if client else None})
+            self.events.write(json.dumps(fields) + "\n")
+
+    # Protocol
+
+    def topic_id(self, name):
+        if name not in self.topics:
+            topic_id = len(self.topics) + 1
+            self.topics[name] = topic_id
+            self.topic_names[topic_id] = name
+        return self.topics[name]
+
+    def handle(self, data, address, now):
+        msg_type, body = parse(data)
+        client = self.by_address.get(address)
+
+        if msg_type == SEARCHGW:
+            self.searched(now)
+            self.event("search", client, Address=address[0])
+            self.send(address, GWINFO, struct.pack(">B", self.args.gateway_id))
+
+        elif msg_type == CONNECT:
+            flags, protocol, duration = struct.unpack_from(">BBH", body)
+            client_id = body[4:].decode(errors="replace")
+            client = self.clients.setdefault(client_id, Client(client_id))
+            if client.address and client.address != address:
+                self.by_address.pop(client.address, None)
+            client.address = address
+            self.by_address[address] = client
+
+            if self.congested():
+                self.send(address, CONNACK, struct.pack(">B", RC_CONGESTION))
+                return
+
+            # A client that was cut off by an outage has reconnected
+            if client.connects and self.outage_end and client.last_seen < self.outage_end:
+                self.reconnects.append(now - self.outage_end)
+            client.connects += 1
+            client.asleep = False
+            client.last_seen = now
+            self.event("connect", client)
+            self.send(address, CONNACK, struct.pack(">B", RC_ACCEPTED))
+
+        elif msg_type == REGISTER:
+            _, msg_id = struct.unpack_from(">HH", body)
+            topic_id = self.topic_id(body[4:].decode(errors="replace"))
+            self.send(address, REGACK, struct.pack(">HHB", topic_id, msg_id, RC_ACCEPTED))
+
+        elif msg_type == SUBSCRIBE:
+            flags, msg_id = struct.unpack_from(">BH", body)
+            topic_type = flags & 0x03
+            topic_id = self.topic_id(body[3:].decode(errors="replace")) if topic_type == TOPIC_NORMAL else 0
+            if client:
+                field = struct.pack(">H", topic_id) if topic_type == TOPIC_NORMAL else body[3:5]
+                client.command_topic = (topic_type, field)
+            self.send(address, SUBACK, struct.pack(">BHHB", flags & 0x60, topic_id, msg_id, RC_ACCEPTED))
+
+        elif msg_type == PUBLISH:
+            flags, topic_id, msg_id = struct.unpack_from(">BHH", body)
+            qos = (flags >> 5) & 0x03
+            topic = self.topic_name(flags & 0x03, body[1:3], topic_id)
+
+            if topic is None:
+                if qos:
+                    self.send(address, PUBACK, struct.pack(">HHB", topic_id, msg_id, RC_INVALID_TOPIC))
+                return
+            if qos and self.congested():
+                self.send(address, PUBACK, struct.pack(">HHB", topic_id, msg_id, RC_CONGESTION))
+                return
+
+            self.publishes += 1
+            if client and client.probe_sent is not None:
+                self.command_latency.append(now - client.probe_sent)
+                client.probe_sent = None
+            if flags & FLAG_DUP:
+                self.duplicates += 1
+            self.account(client, topic, body[5:], now)
+            print("%s %s" % (topic, body[5:].hex()), flush=True)
+
+            if qos:
+                self.send(address, PUBACK, struct.pack(">HHB", topic_id, msg_id, RC_ACCEPTED))
+
+        elif msg_type == PINGREQ:
+            self.send(address, PINGRESP)
+
+        elif msg_type == DISCONNECT:
+            if client:
+                client.asleep = len(body) >= 2
+                self.event("sleep" if client.asleep else "disconnect", client)
+            self.send(address, DISCONNECT)
+
+    def topic_name(self, topic_type, raw, topic_id):
+        if topic_type == TOPIC_SHORT:
+            return raw.decode(errors="replace")
+        if topic_type == TOPIC_PREDEFINED:
+            return "predefined/%d" % topic_id
+        return self.topic_names.get(topic_id)
+
+    # Metrics
+
+    def account(self, client, topic, payload, now):
+        try:
+            if self.args.payload == "binary":
+                message = decode_mqttsn.decode(payload, topic)
+                first = message["Count"]
+                ages = [s["Age"] for s in message["Samples"]]
+                seqs = [(first + i) & 0xFFFF for i in range(len(ages))]
+            elif self.args.payload == "delta":
+                message = decode_mqttsn.decode_delta(payload, topic)
+                ages = [s["Age"] for s in message["Samples"]]
+                seqs = [s["Count"] for s in message["Samples"]]
+            else:
+                message = json.loads(payload.decode())
+                ages = [s["Age"] for s in message["Samples"]]
+                seqs = [(message["Count"] + i) & 0xFFFF for i in range(len(ages))]
+        except (ValueError, KeyError) as e:
+            log("%s: undecodable publication: %s" % (topic, e))
+            return
+
+        self.ages.extend(ages)
+        if client is None:
+            return
+        lost = 0
+        for seq in seqs:
+            if client.next_seq is not None:
+                gap = (seq - client.next_seq) & 0xFFFF
+                if gap < 0x8000:
+                    lost += gap
+            client.next_seq = (seq + 1) & 0xFFFF
+        client.lost += lost
+        self.event("publish", client, Ages=ages, Lost=lost)
+
+    def send_commands(self, now):
+        # QoS0, as the clients subscribe. "state" goes last, so the latency
+        # covers the commands sent before it.
+        for client in self.clients.values():
+            if not client.address or not client.command_topic or client.asleep:
+                continue
+            if client.probe_sent is not None:
+                self.unanswered += 1
+            topic_type, field = client.command_topic
+            for text in self.args.command + ["state"]:
+                self.commands += 1
+                self.send(client.address, PUBLISH, struct.pack(">B", topic_type) + field + b"\x00\x00" + text.encode())
+            self.event("command", client, Commands=self.args.command)
+            client.probe_sent = now
+
+    def searched(self, now):
+        # Multicast load, in all and in the busiest second
+        self.searches += 1
+        if self.search_second != int(now):
+            self.search_second = int(now)
+            self.search_count = 0
+        self.search_count += 1
+        self.search_peak = max(self.search_peak, self.search_count)
+
+    def report(self):
+        summary = {
+            "Clients": len(self.clients),
+            "Asleep": sum(c.asleep for c in self.clients.values()),
+            "Connects": sum(c.connects for c in self.clients.values()),
+            "Publishes": self.publishes,
+            "Duplicates": self.duplicates,
+            "Rejected": self.rejected,
+            "DatagramsDropped": self.dropped,
+            "SamplesLost": sum(c.lost for c in self.clients.values()),
+            "Reconnects": len(self.reconnects),
+            "ReconnectP50": percentile(self.reconnects, 50),
+            "ReconnectMax": max(self.reconnects) if self.reconnects else None,
+            "Searches": self.searches,
+            "SearchPeak": self.search_peak,
+            "Commands": self.commands,
+            "CommandsUnanswered": self.unanswered,
+            "CommandLatencyP50": percentile(self.command_latency, 50),
+            "CommandLatencyP95": percentile(self.command_latency, 95),
+            "CommandLatencyMax": max(self.command_latency) if self.command_latency else None,
+            "AgeP50": percentile(self.ages, 50),
+            "AgeP95": percentile(self.ages, 95),
+            "AgeP99": percentile(self.ages, 99),
+        }
+        log(json.dumps(summary))
+
+    def run(self):
+        next_report = time.monotonic() + self.args.report
+        try:
+            while True:
+                now = time.monotonic()
+                if now >= next_report:
+                    self.report()
+                    next_report = now + self.args.report
+                if self.next_command is not None and now >= self.next_command and not self.in_outage(now):
+                    self.send_commands(now)
+                    self.next_command = now + self.args.command_every
+
+                readable, _, _ = select.select([self.sock], [], [], 0.1 if self.next_command else 0.5)
+                if not readable:
+                    continue
+                data, address = self.sock.recvfrom(1280)
+                now = time.monotonic()
+                if self.in_outage(now) or self.lose():
+                    continue
+                try:
+                    self.handle(data, address, now)
+                except (ValueError, struct.error) as e:
+                    log("%s: malformed datagram: %s" % (address[0], e))
+
+                client = self.by_address.get(address)
+                if client:
+                    client.last_seen = now
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.report()
+
+
+def log(text):
+    print(time.strftime("%H:%M:%S ") + text, file=sys.stderr, flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="MQTT-SN gateway stand-in with fault injection")
+    parser.add_argument("--port", type=int, default=10000, help="UDP port, CONFIG_MQTT_SNCLIENT_GATEWAY_PORT")
+    parser.add_argument("--multicast", default="ff03::1", help="group to answer SEARCHGW on, empty for none")
+    parser.add_argument("--interface", help="interface to join the multicast group on")
+    parser.add_argument("--gateway-id", type=int, default=1)
+    parser.add_argument("--payload", choices=["json", "binary", "delta"], default="json",
+                        help="payload encoding the nodes were built with")
+    parser.add_argument("--loss", type=float, default=0.0, help="datagram loss probability")
+    parser.add_argument("--congestion", type=float, default=0.0, help="congestion rejection probability")
+    parser.add_argument("--outage-every", type=float, default=0.0, help="seconds between outages")
+    parser.add_argument("--outage-for", type=float, default=60.0, help="outage length in seconds")
+    parser.add_argument("--report", type=float, default=60.0, help="seconds between summaries")
+    parser.add_argument("--seed", type=int, help="random seed, for repeatable runs")
+    parser.add_argument("--events", help="file to append connection and publication events to")
+    parser.add_argument("--command-every", type=float, default=0.0,
+                        help="seconds between sending commands to subscribed clients")
+    parser.add_argument("--command", action="append", default=[],
+                        help="command text sent before the state probe, may be repeated")
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    Gateway(args).run()
+
+
+if __name__ == "__main__":
+    main()
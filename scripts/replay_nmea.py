@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+#
+# Replay an NMEA log into the GNSS UART of a native_posix build, or into any
+# serial port, at the rate the receiver would have sent it.
+#
+# Sentences are grouped into one fix per RMC sentence and a fix is written
+# every 1/--rate seconds. native_posix prints the pty of each UART on start
+# up, e.g. "uart_1 connected to pseudotty: /dev/pts/5".
+#
+# Usage:
+#   replay_nmea.py <nmea file> <tty> [--rate 1] [--loop]
+#
+
+import argparse
+import time
+
+
+def fixes(path):
+    fix = []
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("$"):
+                continue
+            if line[3:6] == "RMC" and fix:
+                yield fix
+                fix = []
+            fix.append(line)
+    if fix:
+        yield fix
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay an NMEA log into a UART")
+    parser.add_argument("nmea", help="NMEA log, one sentence per line")
+    parser.add_argument("tty", help="pty or serial port of the GNSS UART")
+    parser.add_argument("--rate", type=float, default=1.0, help="fixes per second")
+    parser.add_argument("--loop", action="store_true", help="start again at the end of the log")
+    args = parser.parse_args()
+
+    with open(args.tty, "wb", buffering=0) as tty:
+        next_fix = time.monotonic()
+        while True:
+            for fix in fixes(args.nmea):
+                tty.write("".join(line + "\r\n" for line in fix).encode())
+                next_fix += 1.0 / args.rate
+                time.sleep(max(0.0, next_fix - time.monotonic()))
+            if not args.loop:
+                break
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,468 @@
+#!/usr/bin/env python3
+#
+# Soak test many native_posix nodes against the MQTT-SN gateway stand-in.
+#
+# Starts --nodes copies of a native_posix build of the application, each
+# with its own settings flash file and random seed, and joins their 802.15.4
+# UART pipes through a simulated radio medium that delivers every frame to
+# every other node, drops frames with probability --loss and acknowledges
+# unicast frames on behalf of the receiver. mqttsn_gateway.py runs alongside
+# with the --gateway-args given, so its loss, outage and congestion faults
+# apply as well.
+#
+# Nodes are power cycled at random, on average every --reboot-every seconds
+# each: the process is killed and started again on the same flash file, so
+# it comes back with its saved gateway, publish interval and telemetry
+# state. Node output goes to <workdir>/node<N>.log across restarts.
+#
+# A summary is printed to stderr every --report seconds and on exit:
+#   - time from a restart to the node's CONNECT at the gateway
+#   - broadcast frames on the medium, in all and in the busiest second, and
+#     the SEARCHGW that reached the gateway, for the multicast load
+#   - samples received and lost to sequence gaps, and the success rate
+#   - sample age at arrival percentiles
+#   - the largest stack use of each thread over all nodes, from the thread
+#     analyzer output enabled by overlay-soak.conf, and the largest resident
+#     set of a node process
+#   - nodes that exited on their own, e.g. on a fault
+#
+# The gateway is only reachable through a Thread border router. Pass one
+# with --border-router, a command run with {pty} replaced by a pty on the
+# medium that carries the same framing as the node UART pipes. Without one
+# the nodes form a mesh among themselves and the gateway sees no clients.
+#
+# Usage:
+#   west build -b native_posix -- -DOVERLAY_CONFIG=overlay-soak.conf
+#   soak.py build/zephyr/zephyr.exe --nodes 100 --reboot-every 1800 \
+#       --border-router "..." --gateway-args "--payload delta --loss 0.05"
+#
+
+import argparse
+import json
+import os
+import random
+import re
+import selectors
+import shlex
+import signal
+import subprocess
+import sys
+import time
+import tty
+
+PTY_LINE = re.compile(r"(uart|uart_1) connected to pseudotty: (\S+)")
+CLIENT_LINE = re.compile(r"Client ID (\S+)")
+STACK_LINE = re.compile(r"\s(\S[^:]*?)\s*: STACK: unused (\d+) usage (\d+) / (\d+)")
+
+# UART pipe framing of the 802.15.4 driver: type, length, frame
+FRAME_TYPE = 0xF0
+
+FRAME_ACK = 0x02
+FCF_PENDING = 0x10
+FCF_ACK_REQUEST = 0x20
+FCF_PANID_COMPRESSION = 0x40
+ADDR_SHORT = 2
+ADDR_EXT = 3
+BROADCAST = b"\xff\xff"
+
+
+def crc16(data):
+    # IEEE 802.15.4 FCS, CRC-16/KERMIT
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return bytes([crc & 0xFF, crc >> 8])
+
+
+def addresses(frame):
+    # (destination, source) addresses of a MAC frame, None where absent
+    if len(frame) < 3:
+        return None, None
+    fcf = frame[0] | frame[1] << 8
+    dst_mode = (fcf >> 10) & 3
+    src_mode = (fcf >> 14) & 3
+    offset = 3
+    dst = src = None
+    if dst_mode:
+        offset += 2
+        size = 8 if dst_mode == ADDR_EXT else 2
+        dst = frame[offset:offset + size]
+        offset += size
+    if src_mode:
+        if not (fcf & FCF_PANID_COMPRESSION and dst_mode):
+            offset += 2
+        size = 8 if src_mode == ADDR_EXT else 2
+        src = frame[offset:offset + size]
+    return dst, src
+
+
+def percentile(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def log(text):
+    print(time.strftime("%H:%M:%S ") + text, file=sys.stderr, flush=True)
+
+
+class Port:
+    # One end of the medium: a node UART pipe or the border router pty
+    def __init__(self, name, fd):
+        self.name = name
+        self.fd = fd
+        self.buffer = bytearray()
+
+    def frames(self, data):
+        self.buffer += data
+        while True:
+            start = self.buffer.find(bytes([FRAME_TYPE]))
+            if start < 0:
+                self.buffer.clear()
+                return
+            del self.buffer[:start]
+            if len(self.buffer) < 2 or len(self.buffer) < 2 + self.buffer[1]:
+                return
+            frame = bytes(self.buffer[2:2 + self.buffer[1]])
+            del self.buffer[:2 + len(frame)]
+            yield frame
+
+    def write(self, frame):
+        try:
+            os.write(self.fd, bytes([FRAME_TYPE, len(frame)]) + frame)
+        except (BlockingIOError, OSError):
+            pass
+
+
+class Medium:
+    # Delivers every frame to every other port, loses each delivery with
+    # probability --loss and sends the immediate acknowledgement a radio
+    # would when the addressed port received the frame
+    def __init__(self, args, selector):
+        self.args = args
+        self.selector = selector
+        self.ports = []
+        self.owners = {}            # MAC address -> port that sent from it
+        self.frames = 0
+        self.lost = 0
+        self.broadcasts = 0
+        self.broadcast_second = None
+        self.broadcast_count = 0
+        self.broadcast_peak = 0
+
+    def attach(self, port):
+        self.ports.append(port)
+        self.selector.register(port.fd, selectors.EVENT_READ, ("port", port))
+
+    def detach(self, port):
+        if port in self.ports:
+            self.ports.remove(port)
+            self.selector.unregister(port.fd)
+            os.close(port.fd)
+        self.owners = {a: p for a, p in self.owners.items() if p is not port}
+
+    def broadcast(self):
+        # Multicast such as SEARCHGW is flooded as broadcast frames, in all
+        # and in the busiest second
+        second = int(time.monotonic())
+        if self.broadcast_second != second:
+            self.broadcast_second = second
+            self.broadcast_count = 0
+        self.broadcasts += 1
+        self.broadcast_count += 1
+        self.broadcast_peak = max(self.broadcast_peak, self.broadcast_count)
+
+    def receive(self, port):
+        try:
+            data = os.read(port.fd, 4096)
+        except (BlockingIOError, OSError):
+            return
+        for frame in port.frames(data):
+            self.transmit(port, frame)
+
+    def transmit(self, sender, frame):
+        self.frames += 1
+        dst, src = addresses(frame)
+        if src and src != BROADCAST:
+            self.owners[src] = sender
+        if dst == BROADCAST:
+            self.broadcast()
+
+        acked = False
+        for port in self.ports:
+            if port is sender:
+                continue
+            if random.random() < self.args.loss:
+                self.lost += 1
+                continue
+            port.write(frame)
+            acked = acked or self.owners.get(dst) is port
+
+        fcf = frame[0] | frame[1] << 8
+        if acked and fcf & FCF_ACK_REQUEST and (fcf & 7) != FRAME_ACK and random.random() >= self.args.loss:
+            # Frame pending is set for data requests so a polling child
+            # stays awake for whatever its parent has queued
+            ack = bytes([FRAME_ACK | (FCF_PENDING if (fcf & 7) == 3 else 0), 0x00, frame[2]])
+            if crc16(frame[:-2]) == frame[-2:]:
+                ack += crc16(ack)
+            sender.write(ack)
+
+
+class Node:
+    def __init__(self, index, args):
+        self.index = index
+        self.args = args
+        self.process = None
+        self.port = None
+        self.client_id = None
+        self.started = None
+        self.off_until = None
+        self.boots = 0
+        self.connected = True
+        self.output = open(os.path.join(args.workdir, "node%d.log" % index), "a")
+        self.flash = os.path.join(args.workdir, "node%d.bin" % index)
+        self.pending = b""
+
+    def start(self, selector):
+        command = [self.args.executable, "-seed=%d" % (self.args.seed + self.index), "--flash=%s" % self.flash]
+        self.process = subprocess.Popen(command, stdin=subprocess.DEVNULL, stdout=subprocess.PIPE,
+                                        stderr=subprocess.STDOUT, start_new_session=True)
+        os.set_blocking(self.process.stdout.fileno(), False)
+        selector.register(self.process.stdout, selectors.EVENT_READ, ("node", self))
+        self.started = time.time()
+        self.off_until = None
+        self.pending = b""
+        self.boots += 1
+        self.connected = False
+        self.output.write("=== started %s\n" % time.strftime("%Y-%m-%d %H:%M:%S"))
+
+    def stop(self, selector, medium):
+        if self.process and self.process.poll() is None:
+            os.killpg(self.process.pid, signal.SIGKILL)
+            self.process.wait()
+        self.close(selector, medium)
+        self.output.write("=== power cut %s\n" % time.strftime("%Y-%m-%d %H:%M:%S"))
+        self.off_until = time.monotonic() + self.args.off_for
+
+    def close(self, selector, medium):
+        if self.process and not self.process.stdout.closed:
+            selector.unregister(self.process.stdout)
+            self.process.stdout.close()
+        if self.port:
+            medium.detach(self.port)
+            self.port = None
+
+    def read(self):
+        try:
+            data = os.read(self.process.stdout.fileno(), 65536)
+        except BlockingIOError:
+            return []
+        if not data:
+            return None
+        self.output.write(data.decode(errors="replace"))
+        lines = (self.pending + data).split(b"\n")
+        self.pending = lines.pop()
+        return [line.decode(errors="replace") for line in lines]
+
+
+class Soak:
+    def __init__(self, args):
+        self.args = args
+        self.selector = selectors.DefaultSelector()
+        self.medium = Medium(args, self.selector)
+        os.makedirs(args.workdir, exist_ok=True)
+        self.nodes = [Node(i, args) for i in range(args.nodes)]
+        self.by_client = {}
+        self.reboots = 0
+        self.faults = 0
+        self.reconnects = []
+        self.received = 0
+        self.lost = 0
+        self.ages = []
+        self.searches = 0
+        self.stacks = {}            # thread name -> (largest use, size)
+        self.rss = 0
+
+        self.events_path = os.path.join(args.workdir, "events.jsonl")
+        open(self.events_path, "w").close()
+        self.events = open(self.events_path, "r")
+
+        gateway = [sys.executable, os.path.join(os.path.dirname(os.path.abspath(__file__)), "mqttsn_gateway.py"),
+                   "--events", self.events_path, "--report", str(args.report)]
+        gateway += shlex.split(args.gateway_args)
+        self.gateway = subprocess.Popen(gateway, stdout=open(os.path.join(args.workdir, "publications.txt"), "w"),
+                                        stderr=open(os.path.join(args.workdir, "gateway.log"), "w"))
+
+        self.border_router = None
+        if args.border_router:
+            master, slave = os.openpty()
+            tty.setraw(slave)
+            os.set_blocking(master, False)
+            self.medium.attach(Port("border router", master))
+            self.border_router = subprocess.Popen(args.border_router.replace("{pty}", os.ttyname(slave)),
+                                                  shell=True, start_new_session=True)
+
+    # Nodes
+
+    def node_output(self, node):
+        lines = node.read()
+        if lines is None:
+            # End of output: the node exited without being power cycled
+            status = node.process.wait()
+            self.faults += 1
+            log("node %d exited with %d, restarting" % (node.index, status))
+            node.close(self.selector, self.medium)
+            node.start(self.selector)
+            return
+        for line in lines:
+            match = PTY_LINE.search(line)
+            if match and match.group(1) == "uart":
+                fd = os.open(match.group(2), os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+                tty.setraw(fd)
+                node.port = Port("node %d" % node.index, fd)
+                self.medium.attach(node.port)
+            match = CLIENT_LINE.search(line)
+            if match:
+                node.client_id = match.group(1)
+                self.by_client[node.client_id] = node
+            match = STACK_LINE.search(line)
+            if match:
+                thread, used, size = match.group(1), int(match.group(3)), int(match.group(4))
+                if used > self.stacks.get(thread, (0, 0))[0]:
+                    self.stacks[thread] = (used, size)
+
+    def power_cycle(self, now):
+        # Each node is cut on average once every --reboot-every seconds and
+        # powered again --off-for seconds later
+        for node in self.nodes:
+            if node.off_until is not None:
+                if now >= node.off_until:
+                    node.start(self.selector)
+            elif self.args.reboot_every and random.random() < self.args.tick / self.args.reboot_every:
+                node.stop(self.selector, self.medium)
+                self.reboots += 1
+
+    def sample_rss(self):
+        for node in self.nodes:
+            if node.off_until is not None:
+                continue
+            try:
+                with open("/proc/%d/status" % node.process.pid) as f:
+                    for line in f:
+                        if line.startswith("VmHWM:"):
+                            self.rss = max(self.rss, int(line.split()[1]))
+            except (OSError, ValueError):
+                pass
+
+    # Gateway
+
+    def gateway_events(self):
+        for line in self.events:
+            try:
+                event = json.loads(line)
+            except ValueError:
+                continue
+            node = self.by_client.get(event["Client"])
+            if event["Event"] == "connect" and node and not node.connected:
+                # Only restarts count, not the first connection of the run
+                node.connected = True
+                if node.boots > 1:
+                    self.reconnects.append(event["Time"] - node.started)
+            elif event["Event"] == "search":
+                self.searches += 1
+            elif event["Event"] == "publish":
+                self.received += len(event["Ages"])
+                self.lost += event["Lost"]
+                self.ages.extend(event["Ages"])
+
+    def report(self):
+        total = self.received + self.lost
+        summary = {
+            "Nodes": len(self.nodes),
+            "Clients": len(self.by_client),
+            "Reboots": self.reboots,
+            "Faults": self.faults,
+            "Frames": self.medium.frames,
+            "FramesLost": self.medium.lost,
+            "BroadcastFrames": self.medium.broadcasts,
+            "BroadcastPeak": self.medium.broadcast_peak,
+            "Searches": self.searches,
+            "Reconnects": len(self.reconnects),
+            "NotConnected": sum(not n.connected for n in self.nodes),
+            "ReconnectP50": percentile(self.reconnects, 50),
+            "ReconnectP95": percentile(self.reconnects, 95),
+            "ReconnectMax": max(self.reconnects) if self.reconnects else None,
+            "SamplesReceived": self.received,
+            "SamplesLost": self.lost,
+            "SuccessRate": self.received / total if total else None,
+            "AgeP50": percentile(self.ages, 50),
+            "AgeP95": percentile(self.ages, 95),
+            "AgeP99": percentile(self.ages, 99),
+            "StackHighWater": {t: "%d/%d" % s for t, s in sorted(self.stacks.items())},
+            "ProcessRssKiB": self.rss,
+        }
+        log(json.dumps(summary))
+
+    def run(self):
+        for node in self.nodes:
+            node.start(self.selector)
+
+        end = time.monotonic() + self.args.duration if self.args.duration else None
+        next_tick = next_report = time.monotonic()
+        try:
+            while end is None or time.monotonic() < end:
+                for key, _ in self.selector.select(timeout=0.1):
+                    kind, item = key.data
+                    if kind == "port":
+                        self.medium.receive(item)
+                    else:
+                        self.node_output(item)
+
+                now = time.monotonic()
+                if now >= next_tick:
+                    next_tick = now + self.args.tick
+                    self.power_cycle(now)
+                    self.sample_rss()
+                    self.gateway_events()
+                if now >= next_report:
+                    next_report = now + self.args.report
+                    self.report()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            for node in self.nodes:
+                if node.off_until is None:
+                    node.stop(self.selector, self.medium)
+            for process in (self.border_router, self.gateway):
+                if process:
+                    process.send_signal(signal.SIGINT)
+                    process.wait()
+            self.gateway_events()
+            self.report()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Soak test native_posix nodes against the gateway stand-in")
+    parser.add_argument("executable", help="native_posix build of the application, zephyr.exe")
+    parser.add_argument("--nodes", type=int, default=10)
+    parser.add_argument("--duration", type=float, default=0.0, help="seconds to run, 0 until interrupted")
+    parser.add_argument("--loss", type=float, default=0.0, help="802.15.4 frame loss probability")
+    parser.add_argument("--reboot-every", type=float, default=0.0, help="mean seconds between power cuts of a node")
+    parser.add_argument("--off-for", type=float, default=0.5, help="seconds a node stays off")
+    parser.add_argument("--border-router", help="command connecting a border router to the {pty} of the medium")
+    parser.add_argument("--gateway-args", default="", help="arguments for mqttsn_gateway.py")
+    parser.add_argument("--workdir", default="soak", help="directory for flash files, logs and events")
+    parser.add_argument("--report", type=float, default=60.0, help="seconds between summaries")
+    parser.add_argument("--tick", type=float, default=1.0, help="seconds between fault and metric updates")
+    parser.add_argument("--seed", type=int, default=1, help="random seed, for repeatable runs")
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    Soak(args).run()
+
+
+if __name__ == "__main__":
+    main()
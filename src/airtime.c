@@ -0,0 +1,83 @@
+// Includes
+
+#include "airtime.h"
+
+// Definitions
+
+// LoRaWAN uses an 8 symbol preamble, explicit header, CRC and coding rate 4/5
+#define PREAMBLE_SYMBOLS 8
+#define CODING_RATE 1
+
+// EU868 DR7 is 50 kbit/s FSK, 20 us a bit. Preamble, sync word, length and
+// CRC add 11 bytes to the PHY payload.
+#define FSK_US_PER_BYTE (8 * 20)
+#define FSK_OVERHEAD 11
+
+#define HOUR_MS (3600 * 1000LL)
+
+// Functions
+
+static uint32_t airtime_lora_us(uint8_t sf, uint32_t bandwidth_khz, size_t length)
+{
+    // Low data rate optimisation is on when a symbol exceeds 16 ms
+    uint32_t symbol_us = (1000U << sf) / bandwidth_khz;
+    int32_t de = symbol_us > 16000 ? 1 : 0;
+
+    // Semtech AN1200.13, in quarter symbols to keep the 4.25 preamble
+    // symbols exact
+    int32_t numerator = 8 * (int32_t)length - 4 * sf + 28 + 16;
+    int32_t denominator = 4 * (sf - 2 * de);
+    int32_t blocks = numerator > 0 ? (numerator + denominator - 1) / denominator : 0;
+    uint32_t quarter_symbols = (PREAMBLE_SYMBOLS * 4 + 17) + (8 + blocks * (CODING_RATE + 4)) * 4;
+
+    return quarter_symbols * symbol_us / 4;
+}
+
+uint32_t airtime_phy_us(uint8_t dr, size_t length)
+{
+    if (dr <= 5) {
+        // DR0 is SF12 down to DR5 at SF7, all at 125 kHz
+        return airtime_lora_us(12 - dr, 125, length);
+    }
+    if (dr == 6) {
+        return airtime_lora_us(7, 250, length);
+    }
+    if (dr == 7) {
+        return (length + FSK_OVERHEAD) * FSK_US_PER_BYTE;
+    }
+    return 0;
+}
+
+uint32_t airtime_us(uint8_t dr, size_t length)
+{
+    return airtime_phy_us(dr, length + AIRTIME_LORAWAN_OVERHEAD);
+}
+
+uint16_t airtime_join_duty_cycle(int64_t elapsed)
+{
+    if (elapsed < HOUR_MS) {
+        return 100;
+    }
+    if (elapsed < 11 * HOUR_MS) {
+        return 1000;
+    }
+    return 10000;
+}
+
+bool airtime_ready(const struct airtime_tracker *tracker, int64_t now)
+{
+    return now >= tracker->next;
+}
+
+int64_t airtime_wait(const struct airtime_tracker *tracker, int64_t now)
+{
+    return airtime_ready(tracker, now) ? 0 : tracker->next - now;
+}
+
+void airtime_sent(struct airtime_tracker *tracker, int64_t now, uint32_t toa_us)
+{
+    // Round the off time up so the stack never finds the band still busy
+    tracker->next = now + ((uint64_t)toa_us * tracker->duty_cycle + 999) / 1000;
+    tracker->total_us += toa_us;
+    tracker->frames++;
+}
@@ -0,0 +1,50 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// EU868 time on air and duty cycle accounting for the LoRaWAN uplink. Pure
+// arithmetic on the caller's clock, no kernel calls, so schedules can be
+// worked out on the host as well.
+
+// MHDR, FHDR without options, FPort and MIC around the FRMPayload
+#define AIRTIME_LORAWAN_OVERHEAD 13
+
+// MHDR, JoinEUI, DevEUI, DevNonce and MIC
+#define AIRTIME_JOIN_REQUEST_SIZE 23
+
+// Time on air in microseconds of a PHY payload of length bytes at EU868
+// data rate dr (0 to 7). Returns 0 for other rates.
+uint32_t airtime_phy_us(uint8_t dr, size_t length);
+
+// Time on air in microseconds of an uplink carrying length bytes of
+// FRMPayload
+uint32_t airtime_us(uint8_t dr, size_t length);
+
+// Join request duty cycle, as 1/N, elapsed ms after the first attempt. The
+// LoRaWAN backoff allows 1% in the first hour, 0.1% for the next ten hours
+// and 0.01% after that.
+uint16_t airtime_join_duty_cycle(int64_t elapsed);
+
+// Off time after each transmission, as enforced by the LoRaWAN stack per
+// band: a frame of T on air at a 1/duty_cycle limit blocks the band for
+// T * duty_cycle. Zero initialise, then set duty_cycle.
+struct airtime_tracker {
+    uint16_t duty_cycle;        // 100 for 1%
+    int64_t next;               // Clock value the band is free again, ms
+    uint64_t total_us;          // Time on air since boot
+    uint32_t frames;
+};
+
+// Whether a frame can be sent at now, in ms
+bool airtime_ready(const struct airtime_tracker *tracker, int64_t now);
+
+// Milliseconds until a frame can be sent, 0 if it can be sent now
+int64_t airtime_wait(const struct airtime_tracker *tracker, int64_t now);
+
+// Account for a frame of toa_us on air sent at now
+void airtime_sent(struct airtime_tracker *tracker, int64_t now, uint32_t toa_us);
+
+#endif
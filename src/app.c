@@ -0,0 +1,22 @@
+// Includes
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app.h"
+
+// Globals
+
+static atomic_t _triageStatus = ATOMIC_INIT(P0);
+
+// Functions
+
+enum TriageStatus triage_status_get(void)
+{
+    return (enum TriageStatus)atomic_get(&_triageStatus);
+}
+
+void triage_status_set(enum TriageStatus status)
+{
+    atomic_set(&_triageStatus, status);
+}
@@ -1,7 +1,13 @@
 #ifndef APP_H
 #define APP_H
 
-#define VERSION 1
+#include <stdint.h>
+
+// Version 2: positions are int32 in 1e-7 degrees rather than float degrees
+// Version 3: MQTT-SN publications carry a batch of timestamped samples
+// Version 4: LoRaWAN uplinks are delta records, see delta.h
+// Version 5: LoRaWAN uplinks pack several delta records, each with its age
+#define VERSION 5
 
 enum TriageStatus {
     P0 = 0,
@@ -10,7 +16,8 @@ enum TriageStatus {
     P3 = 3
 };
 
-extern int32_t whole_celsius;
-extern uint8_t fraction_celsius;
+// Current triage status, reported by both uplinks and set by command
+enum TriageStatus triage_status_get(void);
+void triage_status_set(enum TriageStatus status);
 
 #endif
@@ -272,13 +272,19 @@ static void notify_location_and_speed_cb(struct bt_lns_client *lns,
 	if (lns_data == NULL) {
 		LOG_WRN("[%s] Speed and Location notification aborted", addr);
 	} else {
+		struct location_position position;
 
-		LOG_INF("[%s] Speed and Location notification: Speed: %u, Lat: %d, Long: %d, Ele: %d",
-		       addr, 
-               lns_data->instant_speed,
-               lns_data->latitude,
-               lns_data->longitude,
-               lns_data->elevation);
+		bt_lns_to_position(lns_data, &position);
+
+		LOG_INF("[%s] Speed and Location notification: Valid: %d, Speed: %d cm/s, Lat: %d, Long: %d, Ele: %d mm",
+		       addr,
+               position.valid,
+               position.speed,
+               position.latitude,
+               position.longitude,
+               position.elevation);
+
+		location_publish(&position, 0, LOCATION_SOURCE_BLE);
 	}
 }
 
@@ -0,0 +1,19 @@
+// Includes
+
+#include "backoff.h"
+
+// Functions
+
+uint32_t backoff_delay_ms(uint32_t min_ms, uint32_t max_ms, uint8_t attempts, uint32_t random)
+{
+    uint32_t window = min_ms;
+
+    for (uint8_t i = 0; i < attempts && window < max_ms; i++) {
+        window *= 2;
+    }
+    if (window > max_ms) {
+        window = max_ms;
+    }
+
+    return window / 2 + random % (window / 2 + 1);
+}
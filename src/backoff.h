@@ -0,0 +1,16 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+// Exponential backoff with jitter. Pure arithmetic on a random number from
+// the caller, no kernel calls, so schedules can be simulated on the host.
+
+// Delay in ms before an attempt preceded by attempts others without an
+// answer. The window starts at min_ms and doubles with every attempt up to
+// max_ms, and the delay is drawn by random from its upper half, so nodes
+// starting together spread out and a window never shrinks to nothing.
+// Doubling stops at the maximum, so the window never overflows.
+uint32_t backoff_delay_ms(uint32_t min_ms, uint32_t max_ms, uint8_t attempts, uint32_t random);
+
+#endif
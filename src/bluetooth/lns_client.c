@@ -8,6 +8,7 @@
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
 
 #include "lns_client.h"
 
@@ -91,7 +92,11 @@ static uint8_t notify_process(struct bt_conn *conn,
 	}
 	if(lns_data.elevation_present)
 	{
-		// Ignore this for now
+		// Elevation - sint24 in 1/100 metres
+		lns_data.elevation = sys_get_le24(pData);
+		if (lns_data.elevation & 0x800000) {
+			lns_data.elevation -= 0x1000000;
+		}
 		pData += 3;
 	}
 	if(lns_data.heading_present)
@@ -483,6 +488,25 @@ struct ble_lns_loc_speed_s *bt_lns_get_last_location_and_speed(struct bt_lns_cli
 }
 
 
+void bt_lns_to_position(const struct ble_lns_loc_speed_s *lns_data,
+			struct location_position *position)
+{
+	memset(position, 0, sizeof(*position));
+
+	position->valid = lns_data->location_present;
+	if (lns_data->location_present) {
+		position->latitude = lns_data->latitude;
+		position->longitude = lns_data->longitude;
+	}
+	if (lns_data->elevation_present) {
+		position->elevation = lns_data->elevation * 10;
+	}
+	if (lns_data->instant_speed_present) {
+		position->speed = lns_data->instant_speed;
+	}
+}
+
+
 int bt_lns_start_per_read_location_and_speed(struct bt_lns_client *lns,
 					int32_t interval,
 					bt_lns_notify_location_and_speed_cb func)
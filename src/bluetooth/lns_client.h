@@ -22,7 +22,7 @@ struct ble_lns_loc_speed_s
 //    ble_lns_speed_distance_format_t data_format;                               /**< Format of data (either 2D or 3D). */
 //    ble_lns_elevation_source_t      elevation_source;                          /**< Source of the elevation measurement. */
 //    ble_lns_heading_source_t        heading_source;                            /**< Source of the heading measurement. */
-    uint16_t                        instant_speed;                             /**< Instantaneous Speed (1/10 meter per sec). */
+    uint16_t                        instant_speed;                             /**< Instantaneous Speed (1/100 meter per sec). */
     uint32_t                        total_distance;                            /**< Total Distance (meters), size=24 bits. */
     int32_t                         latitude;                                  /**< Latitude (10e-7 degrees). */
     int32_t                         longitude;                                 /**< Longitude (10e-7 degrees). */
@@ -46,6 +46,8 @@ struct ble_lns_loc_speed_s
 #include <zephyr/bluetooth/uuid.h>
 #include <bluetooth/gatt_dm.h>
 
+#include "location.h"
+
 /**
  * @brief Value that shows that the flags are invalid.
  *
@@ -215,6 +217,18 @@ int bt_lns_read_location_and_speed(struct bt_lns_client *lns, bt_lns_read_cb fun
  */
 struct ble_lns_loc_speed_s *bt_lns_get_last_location_and_speed(struct bt_lns_client *lns);
 
+/**
+ * @brief Convert a location and speed value to the shared position type.
+ *
+ * Fields that are not present in the value are reported as zero, and the
+ * position is only valid when the location is present.
+ *
+ * @param lns_data Location and speed value.
+ * @param position Position to fill in.
+ */
+void bt_lns_to_position(const struct ble_lns_loc_speed_s *lns_data,
+			struct location_position *position);
+
 /**
  * @brief Check whether notification is supported by the service.
  *
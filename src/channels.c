@@ -0,0 +1,29 @@
+// Includes
+
+#include "channels.h"
+
+// Channels
+
+ZBUS_CHAN_DEFINE(location_chan,
+    struct location_snapshot,
+    NULL,
+    NULL,
+    ZBUS_OBSERVERS_EMPTY,
+    ZBUS_MSG_INIT(0)
+);
+
+ZBUS_CHAN_DEFINE(temperature_chan,
+    struct temperature_sample,
+    NULL,
+    NULL,
+    ZBUS_OBSERVERS_EMPTY,
+    ZBUS_MSG_INIT(0)
+);
+
+ZBUS_CHAN_DEFINE(network_chan,
+    struct network_status,
+    NULL,
+    NULL,
+    ZBUS_OBSERVERS_EMPTY,
+    ZBUS_MSG_INIT(0)
+);
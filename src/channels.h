@@ -0,0 +1,39 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+// Includes
+
+#include <zephyr/zbus/zbus.h>
+
+#include "location.h"
+
+// Definitions
+
+// Temperature sample published by the temperature sampler
+struct temperature_sample {
+    int32_t temperature;    // 1/100 degrees C
+    int64_t timestamp;      // k_uptime_get() at measurement, 0 before the first sample
+};
+
+// Thread attachment published by the OpenThread client
+struct network_status {
+    uint8_t role;           // otDeviceRole
+    uint16_t rloc16;
+};
+
+// Channels
+
+// Every position published to the location store, as struct location_snapshot.
+// Observers are notified on each new fix; consumers that only need the latest
+// position at their own rate can use location_get() instead.
+ZBUS_CHAN_DECLARE(location_chan);
+
+// Latest internal temperature, as struct temperature_sample. Sampled once for
+// all consumers; uplinks read the latest value with zbus_chan_read().
+ZBUS_CHAN_DECLARE(temperature_chan);
+
+// Thread role and RLOC16, as struct network_status, updated on every change so
+// the telemetry sampler does not need an OpenThread instance.
+ZBUS_CHAN_DECLARE(network_chan);
+
+#endif
@@ -0,0 +1,241 @@
+// Includes
+
+#include "command.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/reboot.h>
+
+#include "app.h"
+#include "gpio.h"
+#include "mqttsn.h"
+#include "telemetry.h"
+#include "uplink.h"
+#if defined(CONFIG_LORAWAN)
+#include "lorawan_client.h"
+#endif
+
+// Definitions
+
+#define QUEUE_DEPTH CONFIG_COMMAND_QUEUE_DEPTH
+#define MAX_LENGTH CONFIG_COMMAND_MAX_LENGTH
+
+#define IDENTIFY_TOGGLES 20
+#define IDENTIFY_PERIOD_MS 250
+
+#define REBOOT_DELAY K_SECONDS(1)
+
+LOG_MODULE_REGISTER(command, CONFIG_COMMAND_LOG_LEVEL);
+
+struct command_request {
+    char data[MAX_LENGTH + 1];
+};
+
+typedef int (*command_handler_t)(const char *args);
+
+struct command_entry {
+    const char *name;
+    command_handler_t handler;
+};
+
+// Globals
+
+K_MSGQ_DEFINE(command_queue, sizeof(struct command_request), QUEUE_DEPTH, 4);
+
+// Command handlers
+
+static int command_identify(const char *args)
+{
+    otLedBlink(LED_YELLOW, IDENTIFY_TOGGLES, IDENTIFY_PERIOD_MS);
+    return 0;
+}
+
+static int command_interval(const char *args)
+{
+    char *end;
+    long seconds = strtol(args, &end, 10);
+
+    if (end == args || *end != '\0') {
+        return -EINVAL;
+    }
+
+    // The same interval for both uplinks, applied to neither if MQTT-SN
+    // rejects it
+    int err = mqttsnSetPublishInterval(seconds);
+    if (err) {
+        return err;
+    }
+    return uplink_set_interval(UPLINK_LORAWAN, seconds);
+}
+
+static int command_triage(const char *args)
+{
+    // Accept both "P2" and "2"
+    if (*args == 'P' || *args == 'p') {
+        args++;
+    }
+    if (args[0] < '0' || args[0] > '3' || args[1] != '\0') {
+        return -EINVAL;
+    }
+
+    triage_status_set(args[0] - '0');
+
+    // Sampled straight away so the change goes out as a priority message
+    telemetry_sample_now(false);
+    return 0;
+}
+
+static void reboot_work_handler(struct k_work *work)
+{
+    sys_reboot(SYS_REBOOT_COLD);
+}
+
+static K_WORK_DELAYABLE_DEFINE(reboot_work, reboot_work_handler);
+
+static int command_reboot(const char *args)
+{
+    // Give the acknowledgement a chance to leave first
+    k_work_schedule(&reboot_work, REBOOT_DELAY);
+    return 0;
+}
+
+static int command_state(const char *args)
+{
+    LOG_INF("Triage P%d, uptime %u s", triage_status_get(), (uint32_t)(k_uptime_get() / 1000));
+
+    // A fresh sample of the state, published now
+    telemetry_sample_now(false);
+    mqttsnPublishNow();
+    return 0;
+}
+
+static int command_position(const char *args)
+{
+    // A fresh sample, sent as a priority message over every uplink
+    telemetry_sample_now(true);
+    mqttsnPublishNow();
+    return 0;
+}
+
+#if defined(CONFIG_LORAWAN)
+static int command_class(const char *args)
+{
+    // Accept "A" and "C", or the enum lorawan_class value of binary downlinks
+    if (args[0] == '\0' || args[1] != '\0') {
+        return -EINVAL;
+    }
+
+    switch (toupper((unsigned char)args[0])) {
+        case 'A':
+        case '0':
+            return lorawan_client_set_class(LORAWAN_CLASS_A);
+        case 'C':
+        case '2':
+            return lorawan_client_set_class(LORAWAN_CLASS_C);
+        default:
+            return -EINVAL;
+    }
+}
+#endif
+
+static const struct command_entry commands[] = {
+    { "identify", command_identify },
+    { "interval", command_interval },
+    { "triage", command_triage },
+    { "reboot", command_reboot },
+    { "state", command_state },
+    { "position", command_position },
+#if defined(CONFIG_LORAWAN)
+    { "class", command_class },
+#endif
+};
+
+// Functions
+
+static void command_execute(char *line)
+{
+    // Split into the name and its argument, trimming surrounding whitespace
+    while (isspace((unsigned char)*line)) {
+        line++;
+    }
+    for (char *end = line + strlen(line); end > line && isspace((unsigned char)end[-1]); ) {
+        *--end = '\0';
+    }
+
+    char *args = line;
+    while (*args && !isspace((unsigned char)*args)) {
+        args++;
+    }
+    if (*args) {
+        *args++ = '\0';
+        while (isspace((unsigned char)*args)) {
+            args++;
+        }
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+        if (!strcmp(line, commands[i].name)) {
+            int err = commands[i].handler(args);
+            if (err) {
+                LOG_WRN("Command %s %s failed: %d", line, args, err);
+            } else {
+                LOG_INF("Command %s %s", line, args);
+            }
+            return;
+        }
+    }
+
+    LOG_WRN("Unknown command: %s", line);
+}
+
+static void command_work_handler(struct k_work *work)
+{
+    struct command_request request;
+
+    while (k_msgq_get(&command_queue, &request, K_NO_WAIT) == 0) {
+        command_execute(request.data);
+    }
+}
+
+static K_WORK_DEFINE(command_work, command_work_handler);
+
+int command_submit(const uint8_t *data, size_t length)
+{
+    struct command_request request;
+
+    if (length > MAX_LENGTH) {
+        return -EMSGSIZE;
+    }
+
+    memcpy(request.data, data, length);
+    request.data[length] = '\0';
+
+    if (k_msgq_put(&command_queue, &request, K_NO_WAIT) != 0) {
+        return -ENOBUFS;
+    }
+
+    k_work_submit(&command_work);
+    return 0;
+}
+
+int command_submit_binary(const uint8_t *data, size_t length)
+{
+    struct command_request request;
+
+    // Queued as text, so both forms go through command_execute()
+    int err = command_decode(data, length, request.data, sizeof(request.data));
+    if (err) {
+        return err;
+    }
+
+    if (k_msgq_put(&command_queue, &request, K_NO_WAIT) != 0) {
+        return -ENOBUFS;
+    }
+
+    k_work_submit(&command_work);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Queue a downlink command for execution on the system work queue. Safe to
+// call from the OpenThread and LoRaWAN callbacks, it only copies the payload.
+// Commands are text, a name optionally followed by an argument, e.g.
+// "interval 60". Returns -EMSGSIZE if the payload is too long and -ENOBUFS
+// if the queue is full.
+int command_submit(const uint8_t *data, size_t length);
+
+// Binary form of the same commands, for downlinks where every byte costs
+// airtime: an opcode followed by a fixed size little-endian unsigned
+// argument, e.g. 02 3c 00 00 00 for "interval 60"
+enum command_opcode {
+    COMMAND_OP_IDENTIFY = 0x01,     // No argument
+    COMMAND_OP_INTERVAL = 0x02,     // uint32 seconds
+    COMMAND_OP_TRIAGE = 0x03,       // uint8 0 to 3
+    COMMAND_OP_REBOOT = 0x04,       // No argument
+    COMMAND_OP_STATE = 0x05,        // No argument
+    COMMAND_OP_POSITION = 0x06,     // No argument
+    COMMAND_OP_CLASS = 0x07,        // uint8 0 for class A, 2 for class C
+};
+
+// Queue a binary command, decoded into the text form. Returns the errors of
+// command_decode() and -ENOBUFS if the queue is full.
+int command_submit_binary(const uint8_t *data, size_t length);
+
+// Decode a binary command into its text form in text, of size bytes. No
+// kernel calls, so it also runs in the host tests. Returns -EINVAL if the
+// command is empty or the argument size does not match the opcode, -ENOENT
+// for an unknown opcode and -EMSGSIZE if the text would not fit.
+int command_decode(const uint8_t *data, size_t length, char *text, size_t size);
+
+#endif
@@ -0,0 +1,65 @@
+// Includes
+
+#include "command.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <zephyr/sys/util.h>
+
+// Definitions
+
+struct command_binary {
+    const char *name;
+    enum command_opcode opcode;
+    uint8_t arg_size;               // Bytes of argument
+};
+
+// Globals
+
+static const struct command_binary binary_commands[] = {
+    { "identify", COMMAND_OP_IDENTIFY, 0 },
+    { "interval", COMMAND_OP_INTERVAL, 4 },
+    { "triage", COMMAND_OP_TRIAGE, 1 },
+    { "reboot", COMMAND_OP_REBOOT, 0 },
+    { "state", COMMAND_OP_STATE, 0 },
+    { "position", COMMAND_OP_POSITION, 0 },
+#if defined(CONFIG_LORAWAN)
+    { "class", COMMAND_OP_CLASS, 1 },
+#endif
+};
+
+// Functions
+
+int command_decode(const uint8_t *data, size_t length, char *text, size_t size)
+{
+    if (length == 0) {
+        return -EINVAL;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(binary_commands); i++) {
+        const struct command_binary *command = &binary_commands[i];
+
+        if (command->opcode != data[0]) {
+            continue;
+        }
+        if (length - 1 != command->arg_size) {
+            return -EINVAL;
+        }
+
+        uint32_t arg = 0;
+        for (size_t j = command->arg_size; j > 0; j--) {
+            arg = (arg << 8) | data[j];
+        }
+
+        int n = command->arg_size ?
+            snprintf(text, size, "%s %u", command->name, (unsigned int)arg) :
+            snprintf(text, size, "%s", command->name);
+        if (n < 0 || (size_t)n >= size) {
+            return -EMSGSIZE;
+        }
+        return 0;
+    }
+
+    return -ENOENT;
+}
@@ -0,0 +1,126 @@
+// Includes
+
+#include "delta.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include "app.h"
+
+// Definitions
+
+#define KEYFRAME_INTERVAL CONFIG_DELTA_KEYFRAME_INTERVAL
+
+BUILD_ASSERT(VERSION < DELTA_KEYFRAME, "VERSION must fit in 7 bits");
+
+// Functions
+
+static void delta_quantise(const struct delta_report *report, struct delta_fields *fields)
+{
+    const struct location_position *position = &report->position;
+
+    fields->status = (report->role & 0x0f) | (report->triage << 4);
+    fields->battery = report->battery;
+    fields->rloc16 = report->rloc16;
+    fields->flags = position->valid ? 0x01 : 0x00;
+    fields->latitude = position->latitude;
+    fields->longitude = position->longitude;
+    fields->elevation = CLAMP(position->elevation / 1000, INT16_MIN, INT16_MAX);
+    fields->speed = CLAMP(position->speed, 0, UINT16_MAX);
+    fields->temperature = CLAMP(report->temperature, INT16_MIN, INT16_MAX);
+}
+
+static uint8_t delta_changed(const struct delta_fields *a, const struct delta_fields *b)
+{
+    uint8_t mask = 0;
+
+    if (a->status != b->status) {
+        mask |= DELTA_FIELD_STATUS;
+    }
+    if (a->battery != b->battery) {
+        mask |= DELTA_FIELD_BATTERY;
+    }
+    if (a->rloc16 != b->rloc16) {
+        mask |= DELTA_FIELD_RLOC16;
+    }
+    if (a->flags != b->flags) {
+        mask |= DELTA_FIELD_FLAGS;
+    }
+    if (a->latitude != b->latitude || a->longitude != b->longitude) {
+        mask |= DELTA_FIELD_POSITION;
+    }
+    if (a->elevation != b->elevation) {
+        mask |= DELTA_FIELD_ELEVATION;
+    }
+    if (a->speed != b->speed) {
+        mask |= DELTA_FIELD_SPEED;
+    }
+    if (a->temperature != b->temperature) {
+        mask |= DELTA_FIELD_TEMPERATURE;
+    }
+
+    return mask;
+}
+
+size_t delta_encode(struct delta_state *state, const struct delta_report *report,
+                    uint16_t seq, uint8_t *data, size_t size)
+{
+    struct delta_fields fields;
+    bool keyframe = !state->valid || state->since_keyframe + 1 >= KEYFRAME_INTERVAL;
+
+    delta_quantise(report, &fields);
+    uint8_t mask = keyframe ? 0xff : delta_changed(&fields, &state->reference);
+
+    if (size < DELTA_MAX_SIZE) {
+        return 0;
+    }
+
+    data[0] = VERSION | (keyframe ? DELTA_KEYFRAME : 0);
+    sys_put_le16(seq, &data[1]);
+    data[3] = mask;
+
+    uint8_t *field = &data[DELTA_HEADER_SIZE];
+
+    if (mask & DELTA_FIELD_STATUS) {
+        *field++ = fields.status;
+    }
+    if (mask & DELTA_FIELD_BATTERY) {
+        *field++ = fields.battery;
+    }
+    if (mask & DELTA_FIELD_RLOC16) {
+        sys_put_le16(fields.rloc16, field);
+        field += 2;
+    }
+    if (mask & DELTA_FIELD_FLAGS) {
+        *field++ = fields.flags;
+    }
+    if (mask & DELTA_FIELD_POSITION) {
+        sys_put_le32(fields.latitude, field);
+        sys_put_le32(fields.longitude, field + 4);
+        field += 8;
+    }
+    if (mask & DELTA_FIELD_ELEVATION) {
+        sys_put_le16(fields.elevation, field);
+        field += 2;
+    }
+    if (mask & DELTA_FIELD_SPEED) {
+        sys_put_le16(fields.speed, field);
+        field += 2;
+    }
+    if (mask & DELTA_FIELD_TEMPERATURE) {
+        sys_put_le16(fields.temperature, field);
+        field += 2;
+    }
+
+    state->reference = fields;
+    state->since_keyframe = keyframe ? 0 : state->since_keyframe + 1;
+    state->valid = true;
+
+    return field - data;
+}
+
+void delta_reset(struct delta_state *state)
+{
+    state->valid = false;
+}
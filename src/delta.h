@@ -0,0 +1,78 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "location.h"
+
+// Change-only telemetry records, shared by the MQTT-SN and LoRaWAN uplinks.
+//
+// A record is a 4 byte header followed by the fields set in its mask, in
+// mask bit order, little-endian. A keyframe carries every field, other
+// records only the fields that differ from the previous record. Fields are
+// sent as absolute values, so the receiver rebuilds the full state by
+// applying each record to the state so far. A lost record shows up as a
+// gap in the sequence numbers and is recovered by the next keyframe.
+//
+//  0     uint8   bit7 keyframe, bits 0..6 VERSION
+//  1..2  uint16  sequence number
+//  3     uint8   field mask
+//  ...           fields, see enum delta_field
+//
+#define DELTA_HEADER_SIZE 4
+#define DELTA_MAX_SIZE (DELTA_HEADER_SIZE + 19)
+
+#define DELTA_KEYFRAME 0x80
+
+enum delta_field {
+    DELTA_FIELD_STATUS      = 0x01,     // uint8, role in bits 0..3, triage in bits 4..7
+    DELTA_FIELD_BATTERY     = 0x02,     // uint8, %
+    DELTA_FIELD_RLOC16      = 0x04,     // uint16
+    DELTA_FIELD_FLAGS       = 0x08,     // uint8, bit0 GPS lock
+    DELTA_FIELD_POSITION    = 0x10,     // int32 latitude, int32 longitude, 1e-7 degrees
+    DELTA_FIELD_ELEVATION   = 0x20,     // int16, m
+    DELTA_FIELD_SPEED       = 0x40,     // uint16, cm/s
+    DELTA_FIELD_TEMPERATURE = 0x80,     // int16, 1/100 degrees C
+};
+
+// Everything an uplink reports
+struct delta_report {
+    uint8_t role;                       // otDeviceRole, 0 when not on Thread
+    uint8_t triage;                     // enum TriageStatus
+    uint8_t battery;                    // %
+    uint16_t rloc16;
+    struct location_position position;
+    int32_t temperature;                // 1/100 degrees C
+};
+
+// Field values as last sent, at wire resolution
+struct delta_fields {
+    uint8_t status;
+    uint8_t battery;
+    uint16_t rloc16;
+    uint8_t flags;
+    int32_t latitude;
+    int32_t longitude;
+    int16_t elevation;
+    uint16_t speed;
+    int16_t temperature;
+};
+
+// Per-uplink encoder state. Zero initialised state starts with a keyframe.
+struct delta_state {
+    struct delta_fields reference;
+    uint8_t since_keyframe;
+    bool valid;
+};
+
+// Encode report as record seq into data, against and then updating state.
+// Returns the record length, or 0 if size is too small.
+size_t delta_encode(struct delta_state *state, const struct delta_report *report,
+                    uint16_t seq, uint8_t *data, size_t size);
+
+// Make the next record a keyframe, e.g. when the receiver may have lost state
+void delta_reset(struct delta_state *state);
+
+#endif
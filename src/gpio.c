@@ -7,8 +7,14 @@
 
 // Protototypes
 
+static void otLedBlinkHandler(struct k_timer *timer);
+
 // Globals
 
+static K_TIMER_DEFINE(ledBlinkTimer, otLedBlinkHandler, NULL);
+static uint8_t _blinkLed;
+static atomic_t _blinkToggles;
+
 static const struct gpio_dt_spec led_yellow = GPIO_DT_SPEC_GET(LED_NODE_YELLOW, gpios);
 static const struct gpio_dt_spec led_red = GPIO_DT_SPEC_GET(LED_NODE_RED, gpios);
 static const struct gpio_dt_spec led_blue = GPIO_DT_SPEC_GET(LED_NODE_BLUE, gpios);
@@ -108,6 +114,24 @@ void otLedRoleIndicator(otDeviceRole role) {
     }
 }
 
+static void otLedBlinkHandler(struct k_timer *timer) {
+    otLedToggle(_blinkLed);
+    if (atomic_dec(&_blinkToggles) <= 1) {
+        k_timer_stop(timer);
+    }
+}
+
+void otLedBlink(uint8_t aLed, uint16_t aToggles, uint32_t aPeriodMs) {
+    k_timer_stop(&ledBlinkTimer);
+    if (aToggles == 0) {
+        return;
+    }
+
+    _blinkLed = aLed;
+    atomic_set(&_blinkToggles, aToggles);
+    k_timer_start(&ledBlinkTimer, K_NO_WAIT, K_MSEC(aPeriodMs));
+}
+
 void otLedInit(void) {
     if (!gpio_is_ready_dt(&led_yellow)) { LOG_WRN("GPIO port validation failed."); }
     if (!gpio_is_ready_dt(&led_red)) { LOG_WRN("GPIO port validation failed."); }
@@ -54,4 +54,8 @@ void otLedSetOn(uint8_t aLed);
 void otLedToggle(uint8_t aLed);
 void otLedRoleIndicator(otDeviceRole role);
 
+// Toggle aLed aToggles times, every aPeriodMs, from a timer without blocking
+// the caller. A new pattern replaces one still running.
+void otLedBlink(uint8_t aLed, uint16_t aToggles, uint32_t aPeriodMs);
+
 #endif
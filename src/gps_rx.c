@@ -0,0 +1,98 @@
+// Includes
+
+#include "gps_rx.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+// Definitions
+
+// The indices run freely and wrap, so they are taken as unsigned and masked
+// rather than reduced with a signed modulo
+#define SLOT(index) ((unsigned long)(index) & (GPS_RX_SLOTS - 1))
+
+BUILD_ASSERT(IS_POWER_OF_TWO(GPS_RX_SLOTS), "CONFIG_GPS_PARSER_RX_SLOTS must be a power of two");
+
+// Functions
+
+static bool gps_rx_end_of_line(struct gps_rx *rx)
+{
+    bool completed = rx->length > 0 && !rx->discard;
+
+    if (completed) {
+        rx->slots[SLOT(atomic_get(&rx->head))][rx->length] = '\0';
+        atomic_inc(&rx->head);
+    }
+    rx->length = 0;
+    rx->discard = false;
+
+    return completed;
+}
+
+static void gps_rx_append(struct gps_rx *rx, const char *data, size_t len)
+{
+    atomic_val_t head = atomic_get(&rx->head);
+
+    if (rx->discard || len == 0) {
+        return;
+    }
+
+    // Don't start a sentence over a slot the parser hasn't released yet,
+    // and don't let an overlong sentence run off the end of its slot.
+    if ((rx->length == 0 && (unsigned long)head - (unsigned long)atomic_get(&rx->tail) >= GPS_RX_SLOTS) ||
+        (rx->length + len > GPS_RX_SLOT_SIZE - 1)) {
+        atomic_inc(&rx->dropped);
+        rx->discard = true;
+        return;
+    }
+
+    memcpy(&rx->slots[SLOT(head)][rx->length], data, len);
+    rx->length += len;
+}
+
+size_t gps_rx_chunk(struct gps_rx *rx, const char *data, size_t len)
+{
+    size_t completed = 0;
+
+    while (len > 0) {
+        size_t run = 0;
+
+        while (run < len && data[run] != '\n' && data[run] != '\r') {
+            run++;
+        }
+
+        gps_rx_append(rx, data, run);
+
+        if (run < len) {
+            completed += gps_rx_end_of_line(rx);
+            run++;
+        }
+
+        data += run;
+        len -= run;
+    }
+
+    return completed;
+}
+
+const char *gps_rx_peek(struct gps_rx *rx)
+{
+    atomic_val_t tail = atomic_get(&rx->tail);
+
+    if (atomic_get(&rx->head) == tail) {
+        return NULL;
+    }
+    return rx->slots[SLOT(tail)];
+}
+
+void gps_rx_release(struct gps_rx *rx)
+{
+    atomic_inc(&rx->tail);
+}
+
+atomic_val_t gps_rx_dropped(struct gps_rx *rx)
+{
+    return atomic_get(&rx->dropped);
+}
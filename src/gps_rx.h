@@ -0,0 +1,43 @@
+#ifndef GPS_RX_H
+#define GPS_RX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <zephyr/sys/atomic.h>
+
+#include "minmea.h"
+
+// Receive ring of NMEA sentence slots between the UART receive path and the
+// parser thread. The receive path assembles characters into the slot at
+// head and the parser consumes the slot at tail, so only the receive path
+// moves the head and only the parser moves the tail. No kernel calls, so
+// the same ring runs in the host tests.
+#define GPS_RX_SLOT_SIZE (MINMEA_MAX_LENGTH + 1)
+#define GPS_RX_SLOTS CONFIG_GPS_PARSER_RX_SLOTS
+
+struct gps_rx {
+    char slots[GPS_RX_SLOTS][GPS_RX_SLOT_SIZE];
+    atomic_t head;
+    atomic_t tail;
+    atomic_t dropped;
+    size_t length;                  // Characters in the slot being assembled
+    bool discard;                   // Dropping the rest of the current line
+};
+
+// Split a chunk of received bytes into sentences, copying each run between
+// line endings into the current slot in one go. Only called from the
+// receive path. Returns the number of sentences completed.
+size_t gps_rx_chunk(struct gps_rx *rx, const char *data, size_t len);
+
+// Oldest completed sentence, NUL terminated, or NULL if there is none. It
+// is parsed in place and stays valid until gps_rx_release().
+const char *gps_rx_peek(struct gps_rx *rx);
+
+// Hand the slot of the oldest sentence back to the receive path
+void gps_rx_release(struct gps_rx *rx);
+
+// Sentences dropped because the ring was full or they were too long
+atomic_val_t gps_rx_dropped(struct gps_rx *rx);
+
+#endif
@@ -16,8 +16,10 @@
 #include <zephyr/drivers/uart.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
 
 #include "gpsparser.h"
+#include "gps_rx.h"
 
 LOG_MODULE_REGISTER(gpsparser, CONFIG_GPS_PARSER_LOG_LEVEL);
 
@@ -28,13 +30,23 @@ LOG_MODULE_REGISTER(gpsparser, CONFIG_GPS_PARSER_LOG_LEVEL);
 #define SLEEP_TIME_MS	100
 #define SLEEP_TIME_MMS	 10
 
+// 1 knot = 1852 m/h = 185200/3600 cm/s
+#define KNOTS_TO_CMS_NUM 185200
+#define KNOTS_TO_CMS_DEN 3600
+
 #define ZEPHYR_USER_NODE DT_PATH(zephyr_user)
 
 const struct gpio_dt_spec gnss_vbckup = GPIO_DT_SPEC_GET(ZEPHYR_USER_NODE, gnss_vbckp_on_gpios);
 const struct gpio_dt_spec gnss_vcc = GPIO_DT_SPEC_GET(ZEPHYR_USER_NODE, gnss_vcc_on_gpios);
 const struct gpio_dt_spec gnss_reset = GPIO_DT_SPEC_GET(ZEPHYR_USER_NODE, gnss_reset_gpios);
 
-const struct device *uart = DEVICE_DT_GET(DT_NODELABEL(uart0));
+#if DT_NODE_EXISTS(DT_ALIAS(gnss_uart))
+#define GNSS_UART_NODE DT_ALIAS(gnss_uart)
+#else
+#define GNSS_UART_NODE DT_NODELABEL(uart0)
+#endif
+
+const struct device *uart = DEVICE_DT_GET(GNSS_UART_NODE);
 
 const struct uart_config uart_cfg = {
 		.baudrate = 115200,
@@ -44,16 +56,97 @@ const struct uart_config uart_cfg = {
 		.flow_ctrl = UART_CFG_FLOW_CTRL_NONE
 	};
 
-#define RX_BUFFER_SIZE MINMEA_MAX_LENGTH
-static volatile bool data_received;
-static int rxdata = 0;
-static char rxbuffer[RX_BUFFER_SIZE];
+// Sentences assembled by the receive path, see gps_rx.h. The semaphore
+// counts the sentences waiting for the parser thread.
+static struct gps_rx rx;
+
+static K_SEM_DEFINE(rx_ready, 0, GPS_RX_SLOTS);
+
+static void gps_rx_received(const char *data, size_t len)
+{
+    for (size_t completed = gps_rx_chunk(&rx, data, len); completed > 0; completed--) {
+        k_sem_give(&rx_ready);
+    }
+}
+
+#if defined(CONFIG_GPS_PARSER_RX_ASYNC)
+
+#define RX_ASYNC_BUF_SIZE CONFIG_GPS_PARSER_RX_ASYNC_BUF_SIZE
+#define RX_ASYNC_TIMEOUT_US CONFIG_GPS_PARSER_RX_ASYNC_TIMEOUT_US
+
+// Double buffered DMA reception. The driver asks for the next buffer while
+// the current one is being filled, so we alternate between the two.
+static uint8_t rx_async_bufs[2][RX_ASYNC_BUF_SIZE];
+static uint8_t rx_async_next;
+
+static void uart_async_callback(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+    switch (evt->type) {
+        case UART_RX_RDY:
+            gps_rx_received((const char *)&evt->data.rx.buf[evt->data.rx.offset], evt->data.rx.len);
+            break;
+
+        case UART_RX_BUF_REQUEST:
+            uart_rx_buf_rsp(dev, rx_async_bufs[rx_async_next], RX_ASYNC_BUF_SIZE);
+            rx_async_next ^= 1;
+            break;
+
+        case UART_RX_STOPPED:
+            LOG_WRN("UART RX stopped (reason %d)", evt->data.rx_stop.reason);
+            break;
+
+        case UART_RX_DISABLED:
+            // Re-arm reception after an error or when the buffers ran out
+            rx_async_next = 1;
+            uart_rx_enable(dev, rx_async_bufs[0], RX_ASYNC_BUF_SIZE, RX_ASYNC_TIMEOUT_US);
+            break;
+
+        default:
+            break;
+    }
+}
+
+#elif defined(CONFIG_GPS_PARSER_RX_POLL)
+
+#define RX_POLL_INTERVAL K_MSEC(CONFIG_GPS_PARSER_RX_POLL_INTERVAL_MS)
+
+// For UARTs without an interrupt API, e.g. the native_posix pty. The
+// driver buffers what arrives between polls.
+static void uart_poll_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(uart_poll_work, uart_poll_handler);
+
+static void uart_poll_handler(struct k_work *work)
+{
+    char rxchars[16];
+    size_t len = 0;
+    unsigned char c;
+
+    while (uart_poll_in(uart, &c) == 0) {
+        rxchars[len++] = c;
+        if (len == sizeof(rxchars)) {
+            gps_rx_received(rxchars, len);
+            len = 0;
+        }
+    }
+
+    if (len > 0) {
+        gps_rx_received(rxchars, len);
+    }
+
+    k_work_schedule(&uart_poll_work, RX_POLL_INTERVAL);
+}
+
+#else
 
 static void uart_fifo_callback(const struct device *dev, void *user_data)
 {
 	ARG_UNUSED(user_data);
 
-    char rxchar;
+    char rxchars[16];
+    int len;
 
 	/* Verify uart_irq_update() */
 	if (!uart_irq_update(dev)) {
@@ -65,39 +158,334 @@ static void uart_fifo_callback(const struct device *dev, void *user_data)
 	while(uart_irq_rx_ready(dev)) {
 
 		/* Verify uart_fifo_read() */
-		uart_fifo_read(dev, &rxchar, 1);
-
-        if(!data_received) {
-            if(rxdata < RX_BUFFER_SIZE) {
-                if ((rxchar == '\n') || (rxchar == '\r')) {
-                    rxbuffer[rxdata] = '\0';
-                    rxdata =0;
-                    data_received = true;
-                } else {
-                    rxbuffer[rxdata++] = rxchar;
-                }
-            }
+		len = uart_fifo_read(dev, rxchars, sizeof(rxchars));
+        if (len <= 0) {
+            break;
         }
+
+        gps_rx_received(rxchars, len);
 	}
 }
 
-RmcHandler _rmcHandler;
+#endif
+
+// Raw sentence logging, off by default and limited to one sentence per
+// CONFIG_GPS_PARSER_RAW_LOG_INTERVAL_MS when enabled.
+static atomic_t raw_log_enabled;
+static int64_t raw_log_last;
 
-void set_callback_rmc( RmcHandler handler)
+void gps_parser_set_raw_log(bool enable)
 {
-    _rmcHandler = handler;
+    atomic_set(&raw_log_enabled, enable);
 }
 
-GgaHandler _ggaHandler;
+#if defined(CONFIG_SHELL)
+static int cmd_gps_rawlog(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc < 2) {
+        shell_print(sh, "Raw sentence logging is %s", atomic_get(&raw_log_enabled) ? "on" : "off");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "on")) {
+        gps_parser_set_raw_log(true);
+    } else if (!strcmp(argv[1], "off")) {
+        gps_parser_set_raw_log(false);
+    } else {
+        shell_error(sh, "Usage: gps rawlog [on|off]");
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(gps_cmds,
+    SHELL_CMD_ARG(rawlog, NULL, "Show or set raw NMEA sentence logging [on|off]", cmd_gps_rawlog, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(gps, &gps_cmds, "GNSS parser commands", NULL);
+#endif
+
+// Position assembled from RMC (fix, coordinates and speed) and GGA (elevation
+// and fix quality), published to the location store on every RMC
+static struct location_position position;
+static uint8_t fix_quality;
+
+// Sentence types each consumer has subscribed to, see gps_parser_subscribe(),
+// and their union, which is all the dispatcher looks at. The location store
+// always takes RMC and GGA; the debug logging takes the rest when enabled.
+#define CONSUMER_LOCATION 0
+#define CONSUMER_DEBUG 1
+#define CONSUMERS (CONSUMER_DEBUG + 1 + CONFIG_GPS_PARSER_CONSUMERS)
+
+#define LOCATION_SENTENCES \
+    (MINMEA_SENTENCE_MASK(MINMEA_SENTENCE_RMC) | MINMEA_SENTENCE_MASK(MINMEA_SENTENCE_GGA))
+
+#if defined(CONFIG_GPS_PARSER_DEBUG_SENTENCES)
+#define DEBUG_SENTENCES \
+    (MINMEA_SENTENCE_MASK(MINMEA_SENTENCE_GST) | MINMEA_SENTENCE_MASK(MINMEA_SENTENCE_GSV) | \
+     MINMEA_SENTENCE_MASK(MINMEA_SENTENCE_VTG) | MINMEA_SENTENCE_MASK(MINMEA_SENTENCE_ZDA))
+#else
+#define DEBUG_SENTENCES 0
+#endif
+
+static K_MUTEX_DEFINE(consumers_lock);
+static uint32_t consumer_masks[CONSUMERS] = {
+    [CONSUMER_LOCATION] = LOCATION_SENTENCES,
+    [CONSUMER_DEBUG] = DEBUG_SENTENCES,
+};
+static uint32_t consumers_used = BIT(CONSUMER_LOCATION) | BIT(CONSUMER_DEBUG);
+static atomic_t subscribed = ATOMIC_INIT(LOCATION_SENTENCES | DEBUG_SENTENCES);
 
-void set_callback_gga( GgaHandler handler)
+BUILD_ASSERT(CONSUMERS <= 32, "Too many GNSS sentence consumers");
+
+// Called with consumers_lock held
+static void gps_consumers_update(void)
+{
+    uint32_t mask = 0;
+
+    for (int i = 0; i < CONSUMERS; i++) {
+        mask |= consumer_masks[i];
+    }
+    atomic_set(&subscribed, mask);
+}
+
+int gps_parser_subscribe(uint32_t mask)
+{
+    int handle = -ENOMEM;
+
+    k_mutex_lock(&consumers_lock, K_FOREVER);
+    for (int i = CONSUMER_DEBUG + 1; i < CONSUMERS; i++) {
+        if (!(consumers_used & BIT(i))) {
+            consumers_used |= BIT(i);
+            consumer_masks[i] = mask;
+            gps_consumers_update();
+            handle = i;
+            break;
+        }
+    }
+    k_mutex_unlock(&consumers_lock);
+
+    return handle;
+}
+
+int gps_parser_set_subscription(int handle, uint32_t mask)
 {
-    _ggaHandler = handler;
+    int ret = 0;
+
+    k_mutex_lock(&consumers_lock, K_FOREVER);
+    if (handle <= CONSUMER_DEBUG || handle >= CONSUMERS || !(consumers_used & BIT(handle))) {
+        ret = -EINVAL;
+    } else {
+        consumer_masks[handle] = mask;
+        gps_consumers_update();
+    }
+    k_mutex_unlock(&consumers_lock);
+
+    return ret;
+}
+
+void gps_parser_unsubscribe(int handle)
+{
+    if (gps_parser_set_subscription(handle, 0) == 0) {
+        k_mutex_lock(&consumers_lock, K_FOREVER);
+        consumers_used &= ~BIT(handle);
+        k_mutex_unlock(&consumers_lock);
+    }
+}
+
+// Accepted talker IDs packed as two bytes, from CONFIG_GPS_PARSER_TALKERS
+#define MAX_TALKERS 8
+static uint16_t talkers[MAX_TALKERS];
+static int talker_count;
+
+#define TALKER_ID(a, b) (((uint16_t)(a) << 8) | (uint16_t)(b))
+
+static void gps_talkers_init(void)
+{
+    const char *list = CONFIG_GPS_PARSER_TALKERS;
+
+    while (*list && talker_count < MAX_TALKERS) {
+        if (*list == ' ' || *list == ',') {
+            list++;
+            continue;
+        }
+        if (!list[1]) {
+            break;
+        }
+        talkers[talker_count++] = TALKER_ID(list[0], list[1]);
+        list += 2;
+    }
+}
+
+static bool gps_talker_accepted(const char *line)
+{
+    if (talker_count == 0) {
+        return true;
+    }
+
+    uint16_t talker = TALKER_ID(line[1], line[2]);
+
+    for (int i = 0; i < talker_count; i++) {
+        if (talkers[i] == talker) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void gps_dispatch(const char *line)
+{
+    // Reject on the talker and type bytes before paying for the checksum
+    // and the full parse
+    enum minmea_sentence_id id = minmea_sentence_type(line);
+
+    if (id == MINMEA_UNKNOWN) {
+        LOG_DBG(INDENT_SPACES "$xxxxx sentence is not parsed");
+        return;
+    }
+
+    if (id != MINMEA_INVALID) {
+        if (!(atomic_get(&subscribed) & MINMEA_SENTENCE_MASK(id)) || !gps_talker_accepted(line)) {
+            return;
+        }
+        if (!minmea_check(line, false)) {
+            id = MINMEA_INVALID;
+        }
+    }
+
+    switch (id) {
+        case MINMEA_SENTENCE_RMC: {
+            struct minmea_sentence_rmc frame;
+            if (minmea_parse_rmc(&frame, line)) {
+#if 0
+                LOG_DBG(INDENT_SPACES "$xxRMC: raw coordinates and speed: (%d/%d,%d/%d) %d/%d",
+                        frame.latitude.value, frame.latitude.scale,
+                        frame.longitude.value, frame.longitude.scale,
+                        frame.speed.value, frame.speed.scale);
+                LOG_DBG(INDENT_SPACES "$xxRMC fixed-point coordinates and speed scaled to three decimal places: (%d,%d) %d",
+                        minmea_rescale(&frame.latitude, 1000),
+                        minmea_rescale(&frame.longitude, 1000),
+                        minmea_rescale(&frame.speed, 1000));
+                LOG_DBG(INDENT_SPACES "$xxRMC floating point degree coordinates and speed: (%f,%f) %f",
+                        minmea_tocoord(&frame.latitude),
+                        minmea_tocoord(&frame.longitude),
+                        minmea_tofloat(&frame.speed));
+#endif
+                position.valid = frame.valid;
+                position.latitude = frame.valid ? minmea_tocoord_e7(&frame.latitude) : 0;
+                position.longitude = frame.valid ? minmea_tocoord_e7(&frame.longitude) : 0;
+                position.speed = frame.valid ? minmea_toint(&frame.speed, KNOTS_TO_CMS_NUM, KNOTS_TO_CMS_DEN) : 0;
+
+                location_publish(&position, fix_quality, LOCATION_SOURCE_GNSS);
+            }
+            else {
+                LOG_WRN(INDENT_SPACES "$xxRMC sentence is not parsed");
+            }
+        } break;
+
+        case MINMEA_SENTENCE_GGA: {
+            struct minmea_sentence_gga frame;
+            if (minmea_parse_gga(&frame, line)) {
+                LOG_DBG(INDENT_SPACES "$xxGGA: fix quality: %d", frame.fix_quality);
+
+                // Reported with the next RMC fix
+                position.elevation = minmea_toint(&frame.altitude, 1000, 1);
+                fix_quality = frame.fix_quality;
+            }
+            else {
+                LOG_WRN(INDENT_SPACES "$xxGGA sentence is not parsed");
+            }
+        } break;
+
+        case MINMEA_SENTENCE_GST: {
+            struct minmea_sentence_gst frame;
+            if (minmea_parse_gst(&frame, line)) {
+                LOG_DBG(INDENT_SPACES "$xxGST: raw latitude,longitude and altitude error deviation: (%d/%d,%d/%d,%d/%d)",
+                        frame.latitude_error_deviation.value, frame.latitude_error_deviation.scale,
+                        frame.longitude_error_deviation.value, frame.longitude_error_deviation.scale,
+                        frame.altitude_error_deviation.value, frame.altitude_error_deviation.scale);
+                LOG_DBG(INDENT_SPACES "$xxGST fixed point latitude,longitude and altitude error deviation"
+                    " scaled to one decimal place: (%d,%d,%d)",
+                        minmea_rescale(&frame.latitude_error_deviation, 10),
+                        minmea_rescale(&frame.longitude_error_deviation, 10),
+                        minmea_rescale(&frame.altitude_error_deviation, 10));
+                LOG_DBG(INDENT_SPACES "$xxGST floating point degree latitude, longitude and altitude error deviation: (%f,%f,%f)",
+                        minmea_tofloat(&frame.latitude_error_deviation),
+                        minmea_tofloat(&frame.longitude_error_deviation),
+                        minmea_tofloat(&frame.altitude_error_deviation));
+            }
+            else {
+                LOG_WRN(INDENT_SPACES "$xxGST sentence is not parsed");
+            }
+        } break;
+
+        case MINMEA_SENTENCE_GSV: {
+            struct minmea_sentence_gsv frame;
+            if (minmea_parse_gsv(&frame, line)) {
+                LOG_DBG(INDENT_SPACES "$xxGSV: message %d of %d", frame.msg_nr, frame.total_msgs);
+                LOG_DBG(INDENT_SPACES "$xxGSV: sattelites in view: %d", frame.total_sats);
+                for (int i = 0; i < 4; i++)
+                    LOG_DBG(INDENT_SPACES "$xxGSV: sat nr %d, elevation: %d, azimuth: %d, snr: %d dbm",
+                        frame.sats[i].nr,
+                        frame.sats[i].elevation,
+                        frame.sats[i].azimuth,
+                        frame.sats[i].snr);
+            }
+            else {
+                LOG_WRN(INDENT_SPACES "$xxGSV sentence is not parsed");
+            }
+        } break;
+
+        case MINMEA_SENTENCE_VTG: {
+        struct minmea_sentence_vtg frame;
+        if (minmea_parse_vtg(&frame, line)) {
+                LOG_DBG(INDENT_SPACES "$xxVTG: true track degrees = %f",
+                    minmea_tofloat(&frame.true_track_degrees));
+                LOG_DBG(INDENT_SPACES "        magnetic track degrees = %f",
+                    minmea_tofloat(&frame.magnetic_track_degrees));
+                LOG_DBG(INDENT_SPACES "        speed knots = %f",
+                        minmea_tofloat(&frame.speed_knots));
+                LOG_DBG(INDENT_SPACES "        speed kph = %f",
+                        minmea_tofloat(&frame.speed_kph));
+        }
+        else {
+                LOG_WRN(INDENT_SPACES "$xxVTG sentence is not parsed");
+        }
+        } break;
+
+        case MINMEA_SENTENCE_ZDA: {
+            struct minmea_sentence_zda frame;
+            if (minmea_parse_zda(&frame, line)) {
+                LOG_DBG(INDENT_SPACES "$xxZDA: %d:%d:%d %02d.%02d.%d UTC%+03d:%02d",
+                    frame.time.hours,
+                    frame.time.minutes,
+                    frame.time.seconds,
+                    frame.date.day,
+                    frame.date.month,
+                    frame.date.year,
+                    frame.hour_offset,
+                    frame.minute_offset);
+            }
+            else {
+                LOG_WRN(INDENT_SPACES "$xxZDA sentence is not parsed");
+            }
+        } break;
+
+        case MINMEA_INVALID: {
+            LOG_WRN(INDENT_SPACES "$xxxxx sentence is not valid");
+        } break;
+
+        default: {
+            LOG_DBG(INDENT_SPACES "$xxxxx sentence is not parsed");
+        } break;
+    }
 }
 
 void gpsparser(void)
 {
-    char line[MINMEA_MAX_LENGTH];
+    const char *line;
     int ret;
 
     if (!gpio_is_ready_dt(&gnss_vbckup)) { return; }
@@ -129,156 +517,67 @@ void gpsparser(void)
     int err = uart_configure(uart, &uart_cfg);
 
 	if (err == -ENOSYS) {
-        LOG_ERR("Can't open uart");
+        // Emulated UARTs have no line settings to configure
+        LOG_WRN("UART configuration not supported, using defaults");
+	} else if (err) {
+        LOG_ERR("Can't configure uart: %d", err);
 		return;
 	}
 
+#if defined(CONFIG_GPS_PARSER_RX_ASYNC)
+    err = uart_callback_set(uart, uart_async_callback, NULL);
+    if (err) {
+        LOG_ERR("Can't set uart async callback: %d", err);
+        return;
+    }
+
+    rx_async_next = 1;
+    err = uart_rx_enable(uart, rx_async_bufs[0], RX_ASYNC_BUF_SIZE, RX_ASYNC_TIMEOUT_US);
+    if (err) {
+        LOG_ERR("Can't enable uart async rx: %d", err);
+        return;
+    }
+#elif defined(CONFIG_GPS_PARSER_RX_POLL)
+    k_work_schedule(&uart_poll_work, K_NO_WAIT);
+#else
     /* Verify uart_irq_callback_set() */
     uart_irq_callback_set(uart, uart_fifo_callback);
 
     /* Enable Tx/Rx interrupt before using fifo */
     /* Verify uart_irq_rx_enable() */
     uart_irq_rx_enable(uart);
+#endif
+
+    gps_talkers_init();
+
+    atomic_val_t dropped = 0;
 
     while(1) {
 
-        k_msleep(250);
+        // Block until the ISR has completed a sentence
+        k_sem_take(&rx_ready, K_FOREVER);
 
-        data_received = false;
-        while (data_received == false) {
-            /* Allow other thread/workqueue to work. */
-            continue;
+        // Parse in place, the slot stays ours until it is released
+        line = gps_rx_peek(&rx);
+
+        if (gps_rx_dropped(&rx) != dropped) {
+            dropped = gps_rx_dropped(&rx);
+            LOG_WRN("Dropped %ld sentences", (long)dropped);
         }
- 
-        strncpy(line, rxbuffer, sizeof(line));
-
-        LOG_INF("Rx: >%s<", line);
-            switch (minmea_sentence_id(line, false)) {
-                case MINMEA_SENTENCE_RMC: {
-                    struct minmea_sentence_rmc frame;
-                    if (minmea_parse_rmc(&frame, line)) {
-#if 0
-                        LOG_DBG(INDENT_SPACES "$xxRMC: raw coordinates and speed: (%d/%d,%d/%d) %d/%d",
-                                frame.latitude.value, frame.latitude.scale,
-                                frame.longitude.value, frame.longitude.scale,
-                                frame.speed.value, frame.speed.scale);
-                        LOG_DBG(INDENT_SPACES "$xxRMC fixed-point coordinates and speed scaled to three decimal places: (%d,%d) %d",
-                                minmea_rescale(&frame.latitude, 1000),
-                                minmea_rescale(&frame.longitude, 1000),
-                                minmea_rescale(&frame.speed, 1000));
-                        LOG_DBG(INDENT_SPACES "$xxRMC floating point degree coordinates and speed: (%f,%f) %f",
-                                minmea_tocoord(&frame.latitude),
-                                minmea_tocoord(&frame.longitude),
-                                minmea_tofloat(&frame.speed));
-#endif
-                        if(_rmcHandler) {
-                            _rmcHandler(frame.valid, 
-                                        minmea_tocoord(&frame.latitude), 
-                                        minmea_tocoord(&frame.longitude), 
-                                        minmea_tofloat(&frame.speed));
-                        }
-                    }
-                    else {
-                        LOG_WRN(INDENT_SPACES "$xxRMC sentence is not parsed");
-                    }
-                } break;
-
-                case MINMEA_SENTENCE_GGA: {
-                    struct minmea_sentence_gga frame;
-                    if (minmea_parse_gga(&frame, line)) {
-                        LOG_DBG(INDENT_SPACES "$xxGGA: fix quality: %d", frame.fix_quality);
-
-                        if(_ggaHandler) {
-                            _ggaHandler(minmea_tofloat(&frame.altitude));
-                        }
-                    }
-                    else {
-                        LOG_WRN(INDENT_SPACES "$xxGGA sentence is not parsed");
-                    }
-                } break;
-
-                case MINMEA_SENTENCE_GST: {
-                    struct minmea_sentence_gst frame;
-                    if (minmea_parse_gst(&frame, line)) {
-                        LOG_DBG(INDENT_SPACES "$xxGST: raw latitude,longitude and altitude error deviation: (%d/%d,%d/%d,%d/%d)",
-                                frame.latitude_error_deviation.value, frame.latitude_error_deviation.scale,
-                                frame.longitude_error_deviation.value, frame.longitude_error_deviation.scale,
-                                frame.altitude_error_deviation.value, frame.altitude_error_deviation.scale);
-                        LOG_DBG(INDENT_SPACES "$xxGST fixed point latitude,longitude and altitude error deviation"
-                            " scaled to one decimal place: (%d,%d,%d)",
-                                minmea_rescale(&frame.latitude_error_deviation, 10),
-                                minmea_rescale(&frame.longitude_error_deviation, 10),
-                                minmea_rescale(&frame.altitude_error_deviation, 10));
-                        LOG_DBG(INDENT_SPACES "$xxGST floating point degree latitude, longitude and altitude error deviation: (%f,%f,%f)",
-                                minmea_tofloat(&frame.latitude_error_deviation),
-                                minmea_tofloat(&frame.longitude_error_deviation),
-                                minmea_tofloat(&frame.altitude_error_deviation));
-                    }
-                    else {
-                        LOG_WRN(INDENT_SPACES "$xxGST sentence is not parsed");
-                    }
-                } break;
-
-                case MINMEA_SENTENCE_GSV: {
-                    struct minmea_sentence_gsv frame;
-                    if (minmea_parse_gsv(&frame, line)) {
-                        LOG_DBG(INDENT_SPACES "$xxGSV: message %d of %d", frame.msg_nr, frame.total_msgs);
-                        LOG_DBG(INDENT_SPACES "$xxGSV: sattelites in view: %d", frame.total_sats);
-                        for (int i = 0; i < 4; i++)
-                            LOG_DBG(INDENT_SPACES "$xxGSV: sat nr %d, elevation: %d, azimuth: %d, snr: %d dbm",
-                                frame.sats[i].nr,
-                                frame.sats[i].elevation,
-                                frame.sats[i].azimuth,
-                                frame.sats[i].snr);
-                    }
-                    else {
-                        LOG_WRN(INDENT_SPACES "$xxGSV sentence is not parsed");
-                    }
-                } break;
-
-                case MINMEA_SENTENCE_VTG: {
-                struct minmea_sentence_vtg frame;
-                if (minmea_parse_vtg(&frame, line)) {
-                        LOG_DBG(INDENT_SPACES "$xxVTG: true track degrees = %f",
-                            minmea_tofloat(&frame.true_track_degrees));
-                        LOG_DBG(INDENT_SPACES "        magnetic track degrees = %f",
-                            minmea_tofloat(&frame.magnetic_track_degrees));
-                        LOG_DBG(INDENT_SPACES "        speed knots = %f",
-                                minmea_tofloat(&frame.speed_knots));
-                        LOG_DBG(INDENT_SPACES "        speed kph = %f",
-                                minmea_tofloat(&frame.speed_kph));
-                }
-                else {
-                        LOG_WRN(INDENT_SPACES "$xxVTG sentence is not parsed");
-                }
-                } break;
-
-                case MINMEA_SENTENCE_ZDA: {
-                    struct minmea_sentence_zda frame;
-                    if (minmea_parse_zda(&frame, line)) {
-                        LOG_DBG(INDENT_SPACES "$xxZDA: %d:%d:%d %02d.%02d.%d UTC%+03d:%02d",
-                            frame.time.hours,
-                            frame.time.minutes,
-                            frame.time.seconds,
-                            frame.date.day,
-                            frame.date.month,
-                            frame.date.year,
-                            frame.hour_offset,
-                            frame.minute_offset);
-                    }
-                    else {
-                        LOG_WRN(INDENT_SPACES "$xxZDA sentence is not parsed");
-                    }
-                } break;
-
-                case MINMEA_INVALID: {
-                    LOG_WRN(INDENT_SPACES "$xxxxx sentence is not valid");
-                } break;
-
-                default: {
-                    LOG_WRN(INDENT_SPACES "$xxxxx sentence is not parsed");
-                } break;
+
+        if (atomic_get(&raw_log_enabled)) {
+            int64_t now = k_uptime_get();
+
+            if (now - raw_log_last >= CONFIG_GPS_PARSER_RAW_LOG_INTERVAL_MS) {
+                raw_log_last = now;
+                LOG_INF("Rx: >%s<", line);
             }
+        }
+
+        gps_dispatch(line);
+
+        // Hand the slot back to the ISR
+        gps_rx_release(&rx);
     }
 }
 
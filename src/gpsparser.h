@@ -2,13 +2,22 @@
 #define GPS_PARSER_H
 
 #include "minmea.h"
+#include "location.h"
 
-typedef void (*RmcHandler)(bool valid, float latitude, float longitude, float speed);
+void gps_parser_set_raw_log(bool enable);
 
-void set_callback_rmc(RmcHandler handler);
+// Subscribe a consumer to sentence types, as MINMEA_SENTENCE_MASK() bits.
+// The parser checks and decodes the types at least one consumer wants and
+// drops everything else on its type bytes. Returns a handle for the calls
+// below, or -ENOMEM with CONFIG_GPS_PARSER_CONSUMERS handles in use.
+int gps_parser_subscribe(uint32_t mask);
 
-typedef void (*GgaHandler)(float elevation);
+// Replace the sentence types of a consumer. Types no other consumer wants
+// are dropped again from the next sentence on. Returns -EINVAL for a handle
+// that is not subscribed.
+int gps_parser_set_subscription(int handle, uint32_t mask);
 
-void set_callback_gga(GgaHandler handler);
+// Release a handle and its sentence types
+void gps_parser_unsubscribe(int handle);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+// Includes
+
+#include "location.h"
+#include "channels.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+
+// Globals
+
+// Latest position guarded by a sequence counter. Writers are serialised by
+// the spinlock and make the count odd while they update the snapshot;
+// readers retry until they copy it under the same even count, so they never
+// see a torn latitude/longitude pair and never hold up the writers.
+static struct location_snapshot _snapshot;
+static atomic_t _sequence;
+static struct k_spinlock _writeLock;
+
+// Functions
+
+void location_publish(const struct location_position *position,
+                      uint8_t fix_quality, enum location_source source)
+{
+    struct location_snapshot snapshot = {
+        .position = *position,
+        .fix_quality = fix_quality,
+        .source = source,
+        .timestamp = k_uptime_get(),
+    };
+
+    k_spinlock_key_t key = k_spin_lock(&_writeLock);
+
+    atomic_inc(&_sequence);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    _snapshot = snapshot;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    atomic_inc(&_sequence);
+
+    k_spin_unlock(&_writeLock, key);
+
+    // Notify observers outside the spinlock, zbus may block on its own lock
+    zbus_chan_pub(&location_chan, &snapshot, K_NO_WAIT);
+}
+
+bool location_get(struct location_snapshot *snapshot)
+{
+    atomic_val_t start;
+
+    do {
+        start = atomic_get(&_sequence);
+        if (start & 1) {
+            // Only reachable on SMP, the spinlock masks interrupts on UP
+            continue;
+        }
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        memcpy(snapshot, &_snapshot, sizeof(*snapshot));
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    } while ((start & 1) || atomic_get(&_sequence) != start);
+
+    return snapshot->source != LOCATION_SOURCE_NONE;
+}
@@ -0,0 +1,41 @@
+#ifndef LOCATION_H
+#define LOCATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Fixed point position shared by the position producers (NMEA parser, BLE
+// LNS client) and the uplinks. No floating point is needed anywhere between
+// the NMEA fields and the payloads.
+struct location_position {
+    bool valid;
+    int32_t latitude;   // 1e-7 degrees
+    int32_t longitude;  // 1e-7 degrees
+    int32_t elevation;  // mm
+    int32_t speed;      // cm/s
+};
+
+enum location_source {
+    LOCATION_SOURCE_NONE = 0,
+    LOCATION_SOURCE_GNSS,
+    LOCATION_SOURCE_BLE,
+};
+
+// Consistent copy of the latest published position
+struct location_snapshot {
+    struct location_position position;
+    uint8_t fix_quality;            // GGA fix quality, 0 when unknown
+    enum location_source source;
+    int64_t timestamp;              // k_uptime_get() at publication
+};
+
+// Publish a new position. Safe to call from any thread; publications are
+// serialised and never wait for readers.
+void location_publish(const struct location_position *position,
+                      uint8_t fix_quality, enum location_source source);
+
+// Copy the latest position into snapshot without blocking the producers.
+// Returns false, with snapshot zeroed, if nothing has been published yet.
+bool location_get(struct location_snapshot *snapshot);
+
+#endif
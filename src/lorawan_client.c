@@ -18,6 +18,9 @@
 #include <zephyr/drivers/flash.h>
 #include <zephyr/storage/flash_map.h>
 #include <zephyr/fs/nvs.h>
+#include <zephyr/init.h>
+#include <zephyr/random/rand32.h>
+#include <zephyr/settings/settings.h>
 
 #include "openthread/platform/logging.h"
 #include "openthread/instance.h"
@@ -26,14 +29,80 @@
 
 #include "app.h"
 #include "nvs.h"
-#include "gpsparser.h"
+#include "delta.h"
+#include "telemetry.h"
+#include "uplink.h"
+#include "airtime.h"
+#include "lorawan_pack.h"
+#include "command.h"
 
 #include "lorawan_client.h"
 
-#define DELAY K_SECONDS(30)
+// How often the scheduler is asked whether LoRaWAN should carry telemetry
+#define POLL_INTERVAL K_SECONDS(5)
+
+// Gives OpenThread time to come up, the DevEUI is its factory EUI64
+#define START_DELAY K_SECONDS(5)
+
+#define JOIN_JITTER_MS 1000
+
+#define WORKQ_STACK_SIZE 2048
+#define WORKQ_PRIORITY 7
+
+#define LORAWAN_PORT 2
+#define COMMAND_PORT CONFIG_LORAWAN_CLIENT_COMMAND_PORT
+
+// Room for every buffered sample, so the newest can always be picked
+#define MAX_SAMPLES CONFIG_TELEMETRY_BUFFER_SAMPLES
 
 LOG_MODULE_REGISTER(lorawan_client, CONFIG_LORAWAN_CLIENT_LOG_LEVEL);
 
+// Uplink packed in _payload, committed once sent
+struct lorawan_batch {
+	size_t length;
+	size_t packed;                  // Number of records
+	struct delta_state delta;       // Delta state after the last record
+	uint16_t cursor;                // First telemetry sample not yet sent
+	bool fresh;                     // Buffered samples, not the latest again
+};
+
+static uint8_t _payload[LORAWAN_PACK_BUFFER_SIZE];
+static struct telemetry_sample _samples[MAX_SAMPLES];
+static struct delta_state _delta;
+static uint16_t _count;
+static uint16_t _cursor;
+static bool _cursorValid;
+static enum lorawan_datarate _datarate;
+static struct airtime_tracker _airtime = {
+	.duty_cycle = CONFIG_LORAWAN_CLIENT_DUTY_CYCLE,
+};
+static bool _priority;
+
+static struct k_work_q _workq;
+static K_THREAD_STACK_DEFINE(_workqStack, WORKQ_STACK_SIZE);
+
+static struct nvs_fs _fs;
+static struct lorawan_join_config _joinConfig;
+static uint8_t _devEui[8];
+#ifdef LORAWAN_USE_NVS
+static uint8_t _joinEui[8];
+static uint8_t _appKey[16];
+#else
+static uint8_t _joinEui[] = LORAWAN_JOIN_EUI;
+static uint8_t _appKey[] = LORAWAN_APP_KEY;
+#endif
+#if defined(CONFIG_LORAWAN_NVM_NONE)
+static uint16_t _devNonce;
+#endif
+static struct airtime_tracker _joinAirtime;
+static int64_t _firstJoin;
+static uint32_t _joinAttempts;
+static bool _joined;
+#if defined(CONFIG_LORAWAN_NVM_SETTINGS)
+static bool _sessionSaved;
+#endif
+static enum lorawan_class _class = LORAWAN_CLASS_A;
+
 static void dl_callback(uint8_t port, bool data_pending, int16_t rssi, int8_t snr, uint8_t len, const uint8_t *data)
 {
 	LOG_INF("Port %d, Pending %d, RSSI %ddB, SNR %ddBm", port, data_pending, rssi, snr);
@@ -42,6 +111,19 @@ static void dl_callback(uint8_t port, bool data_pending, int16_t rssi, int8_t sn
 	}
 }
 
+// Runs in the stack's context, so the command is only queued here
+static void command_callback(uint8_t port, bool data_pending, int16_t rssi, int8_t snr, uint8_t len, const uint8_t *data)
+{
+	if (!data || len == 0) {
+		return;
+	}
+
+	int err = command_submit_binary(data, len);
+	if (err) {
+		LOG_WRN("Command rejected: %d", err);
+	}
+}
+
 extern struct otInstance *openthread_get_default_instance(void);
 
 static void lorwan_datarate_changed(enum lorawan_datarate dr)
@@ -50,221 +132,354 @@ static void lorwan_datarate_changed(enum lorawan_datarate dr)
 
 	lorawan_get_payload_sizes(&unused, &max_size);
 	LOG_INF("New Datarate: DR_%d, Max Payload %d", dr, max_size);
+	_datarate = dr;
+}
+
+// Pack as many of the samples not yet sent over LoRaWAN as fit in size,
+// newest first so a backlog never holds back the current state. Without
+// new samples the latest one is sent again. Returns the payload length.
+static size_t lorawan_pack(size_t size, struct lorawan_batch *batch)
+{
+	size_t n = _cursorValid ?
+		telemetry_peek_from(_cursor, _samples, MAX_SAMPLES) :
+		telemetry_peek(_samples, MAX_SAMPLES);
+
+	batch->fresh = n > 0;
+	if (!batch->fresh) {
+		if (!telemetry_latest(&_samples[0])) {
+			return 0;
+		}
+		n = 1;
+	}
+	batch->cursor = _samples[n - 1].seq + 1;
+
+	batch->length = lorawan_pack_newest(_samples, n, k_uptime_get(), _count, &_delta,
+		_payload, size, &batch->packed, &batch->delta);
+	return batch->length;
 }
 
-bool _gnssValid = false;
-float _gnssLatitude = 0.0;
-float _gnssLongitude = 0.0;
-float _gnssElevation = 0.0;
-float _gnssSpeed = 0.0;
+static void lorawan_commit(const struct lorawan_batch *batch)
+{
+	_delta = batch->delta;
+	_count += batch->packed;
+	if (batch->fresh) {
+		_cursor = batch->cursor;
+		_cursorValid = true;
+	}
+}
+
+static void lorawan_uplink_work_handler(struct k_work *work);
+static void lorawan_join_work_handler(struct k_work *work);
+static void lorawan_start_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(lorawan_uplink_work, lorawan_uplink_work_handler);
+static K_WORK_DELAYABLE_DEFINE(lorawan_join_work, lorawan_join_work_handler);
+static K_WORK_DELAYABLE_DEFINE(lorawan_start_work, lorawan_start_work_handler);
+
+// The stack keeps the session itself (DevAddr, keys, frame counters and
+// DevNonce) in settings with CONFIG_LORAWAN_NVM_SETTINGS. Here we only
+// record that there is one to resume, and the class set by command.
+static int lorawan_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	if (!strcmp(name, "class")) {
+		uint8_t class;
+
+		if (len != sizeof(class) || read_cb(cb_arg, &class, len) != len) {
+			return -EINVAL;
+		}
+		if (class != LORAWAN_CLASS_A && class != LORAWAN_CLASS_C) {
+			return -EINVAL;
+		}
+
+		_class = class;
+		return 0;
+	}
 
-// TODO: Need a mutex here
+#if defined(CONFIG_LORAWAN_NVM_SETTINGS)
+	if (!strcmp(name, "session")) {
+		_sessionSaved = true;
+		return 0;
+	}
+#endif
 
-void rmc_handler(bool valid, float latitude, float longitude, float speed)
+	return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(lorawan_client, "lwclient", NULL, lorawan_settings_set, NULL, NULL);
+
+static void lorawan_session_changed(bool joined)
 {
-	_gnssValid = valid;
-	_gnssLatitude = valid ? latitude : 0.0f;
-	_gnssLongitude = valid ? longitude: 0.0f;
-	_gnssSpeed = valid ? speed : 0.0f;
-
-	LOG_INF("Valid: %d, Latitude: %f, Longitude: %f, Speed: %f",
-		valid,
-		latitude,
-		longitude,
-		speed);
+#if defined(CONFIG_LORAWAN_NVM_SETTINGS)
+	uint8_t session = 1;
+	int err = joined ?
+		settings_save_one("lwclient/session", &session, sizeof(session)) :
+		settings_delete("lwclient/session");
+
+	if (err) {
+		LOG_WRN("Failed to update session: %d", err);
+	}
+	_sessionSaved = joined;
+#endif
 }
 
-void gga_handler(float elevation)
+static void lorawan_apply_class(void)
 {
-	_gnssElevation = elevation;
+	int ret = lorawan_set_class(_class);
+	if (ret != 0) {
+		LOG_WRN("Failed to set LoRaWAN class: %d", ret);
+	} else {
+		LOG_INF("Class %c", _class == LORAWAN_CLASS_C ? 'C' : 'A');
+	}
+}
 
-	LOG_INF("Elevation: %f", 
-		elevation);
+static void lorawan_class_work_handler(struct k_work *work)
+{
+	// Otherwise applied once joined
+	if (_joined) {
+		lorawan_apply_class();
+	}
 }
 
-int lorawan_client_thread(void)
+static K_WORK_DEFINE(lorawan_class_work, lorawan_class_work_handler);
+
+int lorawan_client_set_class(enum lorawan_class class)
 {
-	const struct device *lora_dev;
-	static struct nvs_fs fs;
-	
-	struct lorawan_join_config join_cfg;
-	uint16_t dev_nonce = 0;
-
-#ifdef LORAWAN_USE_NVS 
-	uint8_t dev_eui[8];
-	uint8_t join_eui[8];
-	uint8_t app_key[16];
-	
-#else
-	uint8_t dev_eui[8];
+	if (class != LORAWAN_CLASS_A && class != LORAWAN_CLASS_C) {
+		return -ENOTSUP;
+	}
+
+	_class = class;
 
-    // Get EUI64
-    otInstance *instance;
-	instance = openthread_get_default_instance();
-    otLinkGetFactoryAssignedIeeeEui64(instance, (otExtAddress *)&dev_eui);
+	uint8_t value = class;
+	int err = settings_save_one("lwclient/class", &value, sizeof(value));
+	if (err) {
+		LOG_WRN("Failed to save class: %d", err);
+	}
+
+	// The stack is only used from its own work queue
+	k_work_submit_to_queue(&_workq, &lorawan_class_work);
+	return 0;
+}
+
+static void lorawan_joined(void)
+{
+	if (_class != LORAWAN_CLASS_A) {
+		lorawan_apply_class();
+	}
 
-	uint8_t join_eui[] = LORAWAN_JOIN_EUI;
-	uint8_t app_key[] = LORAWAN_APP_KEY;
+	_joined = true;
+	uplink_available(UPLINK_LORAWAN, true);
+	k_work_reschedule_for_queue(&_workq, &lorawan_uplink_work, K_NO_WAIT);
+}
+
+static void lorawan_join_work_handler(struct k_work *work)
+{
+	int64_t now = k_uptime_get();
+
+	if (_joinAttempts++ == 0) {
+		_firstJoin = now;
+	}
+
+	LOG_INF("Joining network using OTAA, attempt %u", _joinAttempts);
+	int ret = lorawan_join(&_joinConfig);
+
+	// Every request counts against the join duty cycle, answered or not
+	_joinAirtime.duty_cycle = airtime_join_duty_cycle(now - _firstJoin);
+	airtime_sent(&_joinAirtime, now, airtime_phy_us(_datarate, AIRTIME_JOIN_REQUEST_SIZE));
+
+#if defined(CONFIG_LORAWAN_NVM_NONE)
+	// Increment DevNonce as per LoRaWAN 1.0.4 Spec. Without NVM support in
+	// the stack it is kept here.
+	_devNonce++;
+	_joinConfig.otaa.dev_nonce = _devNonce;
+	ssize_t bytes_written = nvs_write(&_fs, NVS_DEVNONCE_ID, &_devNonce, sizeof(_devNonce));
+	if (bytes_written < 0) {
+		LOG_WRN("NVS: Failed to write id %d (%d)", NVS_DEVNONCE_ID, bytes_written);
+	}
 #endif
 
-	
-	int ret;
-	ssize_t bytes_written;
+	if (ret == 0) {
+		LOG_INF("Join successful.");
+		lorawan_session_changed(true);
+		lorawan_joined();
+		return;
+	}
+
+	if (ret == -ETIMEDOUT) {
+		LOG_WRN("Timed-out waiting for response.");
+	} else {
+		LOG_WRN("Join failed (%d)", ret);
+	}
+
+	// Retry once the join duty cycle allows, with jitter so that devices
+	// powered up together do not keep colliding
+	int64_t delay = airtime_wait(&_joinAirtime, k_uptime_get()) + sys_rand32_get() % JOIN_JITTER_MS;
+	LOG_INF("Retrying join in %lld ms", (long long)delay);
+	k_work_reschedule_for_queue(&_workq, &lorawan_join_work, K_MSEC(delay));
+}
+
+static void lorawan_uplink_work_handler(struct k_work *work)
+{
+	uint8_t max_next, max_size;
+	struct lorawan_batch batch;
+
+	if (!_joined) {
+		return;
+	}
+	k_work_reschedule_for_queue(&_workq, &lorawan_uplink_work, POLL_INTERVAL);
+
+	// Run early for priority messages, otherwise LoRaWAN only carries
+	// routine telemetry while Thread has been down for a while. A priority
+	// message waits for the band to be free.
+	_priority |= uplink_priority_take();
+
+	int64_t now = k_uptime_get();
+	if (!airtime_ready(&_airtime, now)) {
+		LOG_DBG("Duty cycle, band free in %lld ms", (long long)airtime_wait(&_airtime, now));
+		return;
+	}
+	if (!uplink_route(UPLINK_LORAWAN, _priority)) {
+		return;
+	}
 
-	k_msleep(5000);
+	// Only the fields that changed since the previous record are sent,
+	// with a keyframe every CONFIG_DELTA_KEYFRAME_INTERVAL records, and
+	// as many records as the data rate allows. Uplinks are unconfirmed,
+	// so the backend recovers from loss at the next keyframe.
+	lorawan_get_payload_sizes(&max_next, &max_size);
+	size_t length = lorawan_pack(MIN(max_next, LORAWAN_PACK_MAX_PAYLOAD), &batch);
+	if (length == 0) {
+		return;
+	}
+	uint32_t toa = airtime_us(_datarate, length);
+
+	int ret = lorawan_send(LORAWAN_PORT, _payload, length, LORAWAN_MSG_UNCONFIRMED);
+	if (ret == -EAGAIN) {
+		// The stack disagrees about the band, hold off for the off
+		// time of this frame before trying again
+		LOG_ERR("lorawan_send failed: %d. Continuing...", ret);
+		airtime_sent(&_airtime, now, toa);
+	} else if (ret == -ENOTCONN) {
+		// A resumed session the stack did not restore
+		LOG_WRN("No session, joining");
+		_joined = false;
+		uplink_available(UPLINK_LORAWAN, false);
+		lorawan_session_changed(false);
+		k_work_cancel_delayable(&lorawan_uplink_work);
+		k_work_reschedule_for_queue(&_workq, &lorawan_join_work, K_NO_WAIT);
+	} else if (ret < 0) {
+		LOG_WRN("lorawan_send failed: %d", ret);
+	} else {
+		lorawan_commit(&batch);
+		_priority = false;
+		airtime_sent(&_airtime, now, toa);
+		uplink_sent(UPLINK_LORAWAN);
+		LOG_INF("Sent %zu samples in %zu bytes, DR_%d, %u ms on air, %llu ms since boot",
+			batch.packed, length, _datarate, toa / 1000, (unsigned long long)(_airtime.total_us / 1000));
+	}
+}
+
+static void lorawan_start_work_handler(struct k_work *work)
+{
+	const struct device *lora_dev;
+
+#ifndef LORAWAN_USE_NVS
+	// Get EUI64
+	otLinkGetFactoryAssignedIeeeEui64(openthread_get_default_instance(), (otExtAddress *)_devEui);
+#endif
 
 	LOG_INF("Zephyr LoRaWAN Client. Board: %s", CONFIG_BOARD);
 
-	nvs_initialise(&fs);
-	nvs_read_init_parameter(&fs, NVS_DEVNONCE_ID, &dev_nonce);
-#ifdef LORAWAN_USE_NVS 
-	nvs_read_init_parameter(&fs, NVS_LORAWAN_DEV_EUI_ID, dev_eui);
-	nvs_read_init_parameter(&fs, NVS_LORAWAN_JOIN_EUI_ID, join_eui);
-	nvs_read_init_parameter(&fs, NVS_LORAWAN_APP_KEY_ID, app_key);
+	nvs_initialise(&_fs);
+#if defined(CONFIG_LORAWAN_NVM_NONE)
+	nvs_read_init_parameter(&_fs, NVS_DEVNONCE_ID, &_devNonce);
+#endif
+#ifdef LORAWAN_USE_NVS
+	nvs_read_init_parameter(&_fs, NVS_LORAWAN_DEV_EUI_ID, _devEui);
+	nvs_read_init_parameter(&_fs, NVS_LORAWAN_JOIN_EUI_ID, _joinEui);
+	nvs_read_init_parameter(&_fs, NVS_LORAWAN_APP_KEY_ID, _appKey);
 #endif
 
 	lora_dev = DEVICE_DT_GET(DT_ALIAS(lora0));
 	if (!device_is_ready(lora_dev)) {
 		LOG_WRN("%s: device not ready.", lora_dev->name);
-		return -1;
+		return;
 	}
 
+	// Restores the session kept in settings with CONFIG_LORAWAN_NVM_SETTINGS
 	LOG_INF("Starting LoRaWAN stack.");
-	ret = lorawan_start();
+	int ret = lorawan_start();
 	if (ret < 0) {
 		LOG_WRN("lorawan_start failed: %d", ret);
-		return -1;
+		return;
 	}
 
 	// Enable callbacks
-	struct lorawan_downlink_cb downlink_cb = {
+	static struct lorawan_downlink_cb downlink_cb = {
 		.port = LW_RECV_PORT_ANY,
 		.cb = dl_callback
 	};
 
+	static struct lorawan_downlink_cb command_cb = {
+		.port = COMMAND_PORT,
+		.cb = command_callback
+	};
+
 	lorawan_register_downlink_callback(&downlink_cb);
+	lorawan_register_downlink_callback(&command_cb);
 	lorawan_register_dr_changed_callback(lorwan_datarate_changed);
 
-	join_cfg.mode = LORAWAN_ACT_OTAA;
-	join_cfg.dev_eui = dev_eui;
-	join_cfg.otaa.join_eui = join_eui;
-	join_cfg.otaa.app_key = app_key;
-	join_cfg.otaa.nwk_key = app_key;
-	join_cfg.otaa.dev_nonce = dev_nonce;
+	// The stack reports later changes through lorwan_datarate_changed()
+	_datarate = lorawan_get_min_datarate();
 
-	int i = 1;
+	_joinConfig.mode = LORAWAN_ACT_OTAA;
+	_joinConfig.dev_eui = _devEui;
+	_joinConfig.otaa.join_eui = _joinEui;
+	_joinConfig.otaa.app_key = _appKey;
+	_joinConfig.otaa.nwk_key = _appKey;
+#if defined(CONFIG_LORAWAN_NVM_NONE)
+	_joinConfig.otaa.dev_nonce = _devNonce;
+#endif
 
 	LOG_INF("DevEUI: %02x%02x%02x%02x%02x%02x%02x%02x",
-            dev_eui[0],
-            dev_eui[1],
-            dev_eui[2],
-            dev_eui[3],
-            dev_eui[4],
-            dev_eui[5],
-            dev_eui[6],
-            dev_eui[7]
+            _devEui[0],
+            _devEui[1],
+            _devEui[2],
+            _devEui[3],
+            _devEui[4],
+            _devEui[5],
+            _devEui[6],
+            _devEui[7]
             );
 
-	do {
-		LOG_INF("Joining network using OTAA, dev nonce %d, attempt %d: ", join_cfg.otaa.dev_nonce, i++);
-		ret = lorawan_join(&join_cfg);
-		if (ret < 0) {
-			if ((ret =-ETIMEDOUT)) {
-				LOG_WRN("Timed-out waiting for response.");
-			} else {
-				LOG_WRN("Join failed (%d)", ret);
-			}
-		} else {
-			LOG_INF("Join successful.");
-		}
-
-		// Increment DevNonce as per LoRaWAN 1.0.4 Spec.
-		dev_nonce++;
-		join_cfg.otaa.dev_nonce = dev_nonce;
-		// Save value away in Non-Volatile Storage.
-		bytes_written = nvs_write(&fs, NVS_DEVNONCE_ID, &dev_nonce, sizeof(dev_nonce));
-		if (bytes_written < 0) {
-			LOG_WRN("NVS: Failed to write id %d (%d)", NVS_DEVNONCE_ID, bytes_written);
-		} else {
-			//printf("NVS: Wrote %d bytes to id %d\n",bytes_written, NVS_DEVNONCE_ID);
-		}
-
-		if (ret < 0) {
-			// If failed, wait before re-trying.
-			k_sleep(K_MSEC(5000));
-		}
-
-	} while (ret != 0);
+	settings_subsys_init();
+	settings_load_subtree("lwclient");
 
-#ifdef LORAWAN_CLASS_C
-	printk("Setting device to Class C");
-	ret = lorawan_set_class(LORAWAN_CLASS_C);
-	if (ret != 0) {
-		LOG_WRN("Failed to set LoRaWAN class: %d", ret);
+#if defined(CONFIG_LORAWAN_NVM_SETTINGS)
+	if (_sessionSaved) {
+		LOG_INF("Resuming session, no join needed");
+		lorawan_joined();
+		return;
 	}
 #endif
 
-	int count = 0;
-    enum TriageStatus triage_status = P0;
-	int battery_percentage = 100;
-
-	// Set GNSS callback
-	set_callback_rmc(rmc_handler);
-
-	while (1) {
-
-#define LORAWAN_PORT 2
-#define PAYLOAD_SIZE 16
-		uint8_t payload[PAYLOAD_SIZE];
-
-		// Build test payload format here - keep it similar to OpenThread payload
-        // Byte 0 - \"Version\":\"%s\", 
-		payload[0] = VERSION;
-
-		// Byte 1 - \"Count\":%d, 
-		payload[1] = count++;
-
-		// Byte 2 - \"Status\":\"%s\", 
-		payload[2] = triage_status;
-
-		// Byte 3 - \"Battery\":%d, 
-		payload[3] = battery_percentage;
-
-		// Byte 4 - Bits - bit0 GPSlock
-		payload[4] = _gnssValid ? 0x01: 0x00;
-
-		// Byte 5 .. 8 \"Latitude\":%d, 
-		*((float *)&payload[5]) = _gnssLatitude;
-
-		// Byte 9 .. 12 \"Longitude\":%d, 
-		*((float *)&payload[9]) = _gnssLongitude;
-
-		// Byte 13 .. \"Elevation\":%d,
-		payload[13] = (int)_gnssElevation;
-
-		// Byte 14 \"Speed\":%d, 
-		payload[14] = (int)_gnssSpeed;
+	k_work_reschedule_for_queue(&_workq, &lorawan_join_work, K_NO_WAIT);
+}
 
-		// Byte 15 - \"Temperature\":%d.%02u }";
-		payload[15] = whole_celsius;
+static int lorawan_client_init(void)
+{
+	const struct k_work_queue_config config = {
+		.name = "lorawan",
+	};
 
-		ret = lorawan_send(LORAWAN_PORT, payload, PAYLOAD_SIZE, LORAWAN_MSG_UNCONFIRMED);
-		if (ret == -EAGAIN) {
-			LOG_ERR("lorawan_send failed: %d. Continuing...", ret);
-			k_sleep(DELAY);
-			continue;
-		} else if (ret < 0) {
-			LOG_WRN("lorawan_send failed: %d", ret);
-//			return -1;
-		}
-		else {
-			LOG_INF("Data sent!");
-		}
-		k_sleep(DELAY);
-	}
+	// lorawan_join() and lorawan_send() block until the radio interrupts,
+	// which are handled on the system work queue, so they get their own
+	k_work_queue_start(&_workq, _workqStack, K_THREAD_STACK_SIZEOF(_workqStack),
+		WORKQ_PRIORITY, &config);
 
+	uplink_priority_work(&_workq, &lorawan_uplink_work);
+	k_work_reschedule_for_queue(&_workq, &lorawan_start_work, START_DELAY);
 	return 0;
 }
 
-K_THREAD_DEFINE(lorawan_client_id, 2048, lorawan_client_thread, NULL, NULL, NULL,
-		7, 0, 0);
\ No newline at end of file
+SYS_INIT(lorawan_client_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
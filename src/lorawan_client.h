@@ -4,6 +4,17 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#ifndef LORAWAN_CLIENT_H
+#define LORAWAN_CLIENT_H
+
+#include <zephyr/lorawan/lorawan.h>
+
 //#define LORAWAN_DEV_EUI         { 0x02,0x88,0x88,0x00,0x00,0x33,0x32,0x22 }    // MSB Format!
 #define LORAWAN_JOIN_EUI        { 0x88,0x00,0x00,0x00,0x00,0x00,0x00,0x01 }    // MSB Format!
-#define LORAWAN_APP_KEY         { 0x13,0x0B,0xFE,0x9F,0x9C,0x8A,0x1C,0x35,0x59,0x57,0x9B,0x81,0xEA,0x0E,0xDE,0x7A }
\ No newline at end of file
+#define LORAWAN_APP_KEY         { 0x13,0x0B,0xFE,0x9F,0x9C,0x8A,0x1C,0x35,0x59,0x57,0x9B,0x81,0xEA,0x0E,0xDE,0x7A }
+
+// Switch between class A and class C, kept across reboots and applied once
+// joined. Returns -ENOTSUP for class B.
+int lorawan_client_set_class(enum lorawan_class class);
+
+#endif
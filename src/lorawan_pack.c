@@ -0,0 +1,46 @@
+// Includes
+
+#include "lorawan_pack.h"
+
+// Functions
+
+// Encode samples[first..n) into data, against a copy of the reference state
+static size_t lorawan_pack_encode(struct telemetry_sample *samples, size_t first, size_t n, int64_t now,
+                                  uint16_t seq, const struct delta_state *reference, uint8_t *data,
+                                  struct delta_state *delta)
+{
+    const struct telemetry_encode_context context = {
+        .now = now,
+        .delta = delta,
+        .ages = true,
+    };
+
+    *delta = *reference;
+    for (size_t i = first; i < n; i++) {
+        samples[i].seq = seq + (i - first);
+    }
+    return telemetry_encoder_delta.encode(&context, &samples[first], n - first, data, LORAWAN_PACK_BUFFER_SIZE);
+}
+
+size_t lorawan_pack_newest(struct telemetry_sample *samples, size_t n, int64_t now, uint16_t seq,
+                           const struct delta_state *reference, uint8_t *data, size_t size,
+                           size_t *packed, struct delta_state *delta)
+{
+    // Extend the run back in time while it still fits
+    size_t first = n;
+    while (first > 0) {
+        size_t trial = lorawan_pack_encode(samples, first - 1, n, now, seq, reference, data, delta);
+        if (trial == 0 || trial > size) {
+            break;
+        }
+        first--;
+    }
+
+    *packed = n - first;
+    if (first == n) {
+        return 0;
+    }
+
+    // Encode the chosen run again, the last trial may not have fitted
+    return lorawan_pack_encode(samples, first, n, now, seq, reference, data, delta);
+}
@@ -0,0 +1,32 @@
+#ifndef LORAWAN_PACK_H
+#define LORAWAN_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "delta.h"
+#include "telemetry.h"
+#include "telemetry_encode.h"
+
+// Packing of buffered samples into LoRaWAN uplinks. No kernel or radio
+// calls, so what each data rate carries can be worked out on the host too.
+
+// Largest EU868 FRMPayload, at DR4 and above
+#define LORAWAN_PACK_MAX_PAYLOAD 242
+
+// Records are encoded past the end of the payload and only kept if they
+// fit, as the encoder wants room for a worst case record
+#define LORAWAN_PACK_BUFFER_SIZE (LORAWAN_PACK_MAX_PAYLOAD + TELEMETRY_DELTA_SIZE(1))
+
+// Encode the longest run of samples[0..n) that ends with the newest and
+// fits in size bytes into data, which holds LORAWAN_PACK_BUFFER_SIZE. The
+// records carry their age at now, are numbered on from seq, overwriting
+// the sequence numbers in samples, and are delta encoded against a copy of
+// *reference. Returns the payload length, 0 if not even the newest fits,
+// with the number of samples packed in *packed and the delta state after
+// the last of them in *delta.
+size_t lorawan_pack_newest(struct telemetry_sample *samples, size_t n, int64_t now, uint16_t seq,
+                           const struct delta_state *reference, uint8_t *data, size_t size,
+                           size_t *packed, struct delta_state *delta);
+
+#endif
@@ -16,10 +16,6 @@
 #include "openthread/instance.h"
 #include "openthread/thread.h"
 
-#ifdef CONFIG_NRFX_TEMP
-#include "nrfx_temp.h"
-#endif
-
 #include "utils.h"
 #include "mqttsn.h"
 #include "app_bluetooth.h"
@@ -98,7 +94,9 @@ int main(int aArgc, char *aArgv[])
     return 0;
 }
 
+#if defined(CONFIG_MPSL_ASSERT_HANDLER)
 void mpsl_assert_handle(const char * const file, const uint32_t line)
 {
 	LOG_WRN("Error");
 }
+#endif
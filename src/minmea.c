@@ -89,6 +89,212 @@ static inline bool minmea_isfield(char c) {
     return isprint((unsigned char) c) && c != ',' && c != '*';
 }
 
+/*
+ * Field decoders shared by minmea_scan() and the tokenized parsers below. Each
+ * takes a pointer to the start of a field, or NULL if the field is missing,
+ * and returns false on a parse error.
+ */
+
+static bool minmea_field_c(const char *field, char *out)
+{
+    char value = '\0';
+
+    if (field && minmea_isfield(*field))
+        value = *field;
+
+    *out = value;
+    return true;
+}
+
+static bool minmea_field_d(const char *field, int *out)
+{
+    int value = 0;
+
+    if (field && minmea_isfield(*field)) {
+        switch (*field) {
+            case 'N':
+            case 'E':
+                value = 1;
+                break;
+            case 'S':
+            case 'W':
+                value = -1;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+static bool minmea_field_f(const char *field, struct minmea_float *out)
+{
+    int sign = 0;
+    int_least32_t value = -1;
+    int_least32_t scale = 0;
+
+    if (field) {
+        while (minmea_isfield(*field)) {
+            if (*field == '+' && !sign && value == -1) {
+                sign = 1;
+            } else if (*field == '-' && !sign && value == -1) {
+                sign = -1;
+            } else if (isdigit((unsigned char) *field)) {
+                int digit = *field - '0';
+                if (value == -1)
+                    value = 0;
+                if (value > (INT_LEAST32_MAX-digit) / 10) {
+                    /* we ran out of bits, what do we do? */
+                    if (scale) {
+                        /* truncate extra precision */
+                        break;
+                    } else {
+                        /* integer overflow. bail out. */
+                        return false;
+                    }
+                }
+                value = (10 * value) + digit;
+                if (scale)
+                    scale *= 10;
+            } else if (*field == '.' && scale == 0) {
+                scale = 1;
+            } else if (*field == ' ') {
+                /* Allow spaces at the start of the field. Not NMEA
+                 * conformant, but some modules do this. */
+                if (sign != 0 || value != -1 || scale != 0)
+                    return false;
+            } else {
+                return false;
+            }
+            field++;
+        }
+    }
+
+    if ((sign || scale) && value == -1)
+        return false;
+
+    if (value == -1) {
+        /* No digits were scanned. */
+        value = 0;
+        scale = 0;
+    } else if (scale == 0) {
+        /* No decimal point. */
+        scale = 1;
+    }
+    if (sign)
+        value *= sign;
+
+    *out = (struct minmea_float) {value, scale};
+    return true;
+}
+
+static bool minmea_field_i(const char *field, int *out)
+{
+    int value = 0;
+
+    if (field) {
+        const char *end = field;
+
+        /* Plain unsigned fields that can't overflow are converted inline,
+         * anything else goes through strtol(). */
+        while (end - field < 9 && isdigit((unsigned char) *end)) {
+            value = (10 * value) + (*end - '0');
+            end++;
+        }
+        if (end == field || isdigit((unsigned char) *end)) {
+            char *endptr;
+            value = strtol(field, &endptr, 10);
+            end = endptr;
+        }
+        if (minmea_isfield(*end))
+            return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+static bool minmea_field_t(const char *field, char *buf)
+{
+    // This field is always mandatory.
+    if (!field)
+        return false;
+
+    if (field[0] != '$')
+        return false;
+    for (int f=0; f<5; f++)
+        if (!minmea_isfield(field[1+f]))
+            return false;
+
+    memcpy(buf, field+1, 5);
+    buf[5] = '\0';
+    return true;
+}
+
+static inline int minmea_2digits(const char *digits)
+{
+    return (digits[0] - '0') * 10 + (digits[1] - '0');
+}
+
+static bool minmea_field_D(const char *field, struct minmea_date *date)
+{
+    int d = -1, m = -1, y = -1;
+
+    if (field && minmea_isfield(*field)) {
+        // Always six digits.
+        for (int f=0; f<6; f++)
+            if (!isdigit((unsigned char) field[f]))
+                return false;
+
+        d = minmea_2digits(&field[0]);
+        m = minmea_2digits(&field[2]);
+        y = minmea_2digits(&field[4]);
+    }
+
+    date->day = d;
+    date->month = m;
+    date->year = y;
+    return true;
+}
+
+static bool minmea_field_T(const char *field, struct minmea_time *time_)
+{
+    int h = -1, i = -1, s = -1, u = -1;
+
+    if (field && minmea_isfield(*field)) {
+        // Minimum required: integer time.
+        for (int f=0; f<6; f++)
+            if (!isdigit((unsigned char) field[f]))
+                return false;
+
+        h = minmea_2digits(&field[0]);
+        i = minmea_2digits(&field[2]);
+        s = minmea_2digits(&field[4]);
+        field += 6;
+
+        // Extra: fractional time. Saved as microseconds.
+        if (*field++ == '.') {
+            uint32_t value = 0;
+            uint32_t scale = 1000000LU;
+            while (isdigit((unsigned char) *field) && scale > 1) {
+                value = (value * 10) + (*field++ - '0');
+                scale /= 10;
+            }
+            u = value * scale;
+        } else {
+            u = 0;
+        }
+    }
+
+    time_->hours = h;
+    time_->minutes = i;
+    time_->seconds = s;
+    time_->microseconds = u;
+    return true;
+}
+
 bool minmea_scan(const char *sentence, const char *format, ...)
 {
     bool result = false;
@@ -127,105 +333,22 @@ bool minmea_scan(const char *sentence, const char *format, ...)
 
         switch (type) {
             case 'c': { // Single character field (char).
-                char value = '\0';
-
-                if (field && minmea_isfield(*field))
-                    value = *field;
-
-                *va_arg(ap, char *) = value;
+                minmea_field_c(field, va_arg(ap, char *));
             } break;
 
             case 'd': { // Single character direction field (int).
-                int value = 0;
-
-                if (field && minmea_isfield(*field)) {
-                    switch (*field) {
-                        case 'N':
-                        case 'E':
-                            value = 1;
-                            break;
-                        case 'S':
-                        case 'W':
-                            value = -1;
-                            break;
-                        default:
-                            goto parse_error;
-                    }
-                }
-
-                *va_arg(ap, int *) = value;
+                if (!minmea_field_d(field, va_arg(ap, int *)))
+                    goto parse_error;
             } break;
 
             case 'f': { // Fractional value with scale (struct minmea_float).
-                int sign = 0;
-                int_least32_t value = -1;
-                int_least32_t scale = 0;
-
-                if (field) {
-                    while (minmea_isfield(*field)) {
-                        if (*field == '+' && !sign && value == -1) {
-                            sign = 1;
-                        } else if (*field == '-' && !sign && value == -1) {
-                            sign = -1;
-                        } else if (isdigit((unsigned char) *field)) {
-                            int digit = *field - '0';
-                            if (value == -1)
-                                value = 0;
-                            if (value > (INT_LEAST32_MAX-digit) / 10) {
-                                /* we ran out of bits, what do we do? */
-                                if (scale) {
-                                    /* truncate extra precision */
-                                    break;
-                                } else {
-                                    /* integer overflow. bail out. */
-                                    goto parse_error;
-                                }
-                            }
-                            value = (10 * value) + digit;
-                            if (scale)
-                                scale *= 10;
-                        } else if (*field == '.' && scale == 0) {
-                            scale = 1;
-                        } else if (*field == ' ') {
-                            /* Allow spaces at the start of the field. Not NMEA
-                             * conformant, but some modules do this. */
-                            if (sign != 0 || value != -1 || scale != 0)
-                                goto parse_error;
-                        } else {
-                            goto parse_error;
-                        }
-                        field++;
-                    }
-                }
-
-                if ((sign || scale) && value == -1)
+                if (!minmea_field_f(field, va_arg(ap, struct minmea_float *)))
                     goto parse_error;
-
-                if (value == -1) {
-                    /* No digits were scanned. */
-                    value = 0;
-                    scale = 0;
-                } else if (scale == 0) {
-                    /* No decimal point. */
-                    scale = 1;
-                }
-                if (sign)
-                    value *= sign;
-
-                *va_arg(ap, struct minmea_float *) = (struct minmea_float) {value, scale};
             } break;
 
             case 'i': { // Integer value, default 0 (int).
-                int value = 0;
-
-                if (field) {
-                    char *endptr;
-                    value = strtol(field, &endptr, 10);
-                    if (minmea_isfield(*endptr))
-                        goto parse_error;
-                }
-
-                *va_arg(ap, int *) = value;
+                if (!minmea_field_i(field, va_arg(ap, int *)))
+                    goto parse_error;
             } break;
 
             case 's': { // String value (char *).
@@ -240,82 +363,18 @@ bool minmea_scan(const char *sentence, const char *format, ...)
             } break;
 
             case 't': { // NMEA talker+sentence identifier (char *).
-                // This field is always mandatory.
-                if (!field)
-                    goto parse_error;
-
-                if (field[0] != '$')
+                if (!minmea_field_t(field, va_arg(ap, char *)))
                     goto parse_error;
-                for (int f=0; f<5; f++)
-                    if (!minmea_isfield(field[1+f]))
-                        goto parse_error;
-
-                char *buf = va_arg(ap, char *);
-                memcpy(buf, field+1, 5);
-                buf[5] = '\0';
             } break;
 
             case 'D': { // Date (int, int, int), -1 if empty.
-                struct minmea_date *date = va_arg(ap, struct minmea_date *);
-
-                int d = -1, m = -1, y = -1;
-
-                if (field && minmea_isfield(*field)) {
-                    // Always six digits.
-                    for (int f=0; f<6; f++)
-                        if (!isdigit((unsigned char) field[f]))
-                            goto parse_error;
-
-                    char dArr[] = {field[0], field[1], '\0'};
-                    char mArr[] = {field[2], field[3], '\0'};
-                    char yArr[] = {field[4], field[5], '\0'};
-                    d = strtol(dArr, NULL, 10);
-                    m = strtol(mArr, NULL, 10);
-                    y = strtol(yArr, NULL, 10);
-                }
-
-                date->day = d;
-                date->month = m;
-                date->year = y;
+                if (!minmea_field_D(field, va_arg(ap, struct minmea_date *)))
+                    goto parse_error;
             } break;
 
             case 'T': { // Time (int, int, int, int), -1 if empty.
-                struct minmea_time *time_ = va_arg(ap, struct minmea_time *);
-
-                int h = -1, i = -1, s = -1, u = -1;
-
-                if (field && minmea_isfield(*field)) {
-                    // Minimum required: integer time.
-                    for (int f=0; f<6; f++)
-                        if (!isdigit((unsigned char) field[f]))
-                            goto parse_error;
-
-                    char hArr[] = {field[0], field[1], '\0'};
-                    char iArr[] = {field[2], field[3], '\0'};
-                    char sArr[] = {field[4], field[5], '\0'};
-                    h = strtol(hArr, NULL, 10);
-                    i = strtol(iArr, NULL, 10);
-                    s = strtol(sArr, NULL, 10);
-                    field += 6;
-
-                    // Extra: fractional time. Saved as microseconds.
-                    if (*field++ == '.') {
-                        uint32_t value = 0;
-                        uint32_t scale = 1000000LU;
-                        while (isdigit((unsigned char) *field) && scale > 1) {
-                            value = (value * 10) + (*field++ - '0');
-                            scale /= 10;
-                        }
-                        u = value * scale;
-                    } else {
-                        u = 0;
-                    }
-                }
-
-                time_->hours = h;
-                time_->minutes = i;
-                time_->seconds = s;
-                time_->microseconds = u;
+                if (!minmea_field_T(field, va_arg(ap, struct minmea_time *)))
+                    goto parse_error;
             } break;
 
             case '_': { // Ignore the field.
@@ -336,10 +395,55 @@ parse_error:
     return result;
 }
 
+/*
+ * Single pass tokenizer used by the minmea_parse_* functions. The sentence is
+ * split once into a table of field start pointers and each parser then
+ * decodes its fields by index, without going through a format string and
+ * varargs. Fields before "required" must be present, matching the fields
+ * before ';' in the equivalent minmea_scan() format.
+ */
+
+#define MINMEA_MAX_FIELDS 24
+
+struct minmea_tokens {
+    const char *field[MINMEA_MAX_FIELDS];
+    int count;
+    int required;
+};
+
+static void minmea_tokenize(struct minmea_tokens *tokens, const char *sentence, int required)
+{
+    tokens->field[0] = sentence;
+    tokens->count = 1;
+    tokens->required = required;
+
+    while (tokens->count < MINMEA_MAX_FIELDS) {
+        while (minmea_isfield(*sentence))
+            sentence++;
+        if (*sentence != ',')
+            break;
+        tokens->field[tokens->count++] = ++sentence;
+    }
+}
+
+static inline const char *minmea_token(const struct minmea_tokens *tokens, int index)
+{
+    return index < tokens->count ? tokens->field[index] : NULL;
+}
+
+static inline bool minmea_token_present(const struct minmea_tokens *tokens, int index)
+{
+    return index < tokens->count || index >= tokens->required;
+}
+
+// Decode field "index" with "decoder", failing if a required field is missing.
+#define minmea_decode(tokens, index, decoder, out) \
+    (minmea_token_present(tokens, index) && decoder(minmea_token(tokens, index), out))
+
 bool minmea_talker_id(char talker[3], const char *sentence)
 {
     char type[6];
-    if (!minmea_scan(sentence, "t", type))
+    if (!minmea_field_t(sentence, type))
         return false;
 
     talker[0] = type[0];
@@ -349,53 +453,68 @@ bool minmea_talker_id(char talker[3], const char *sentence)
     return true;
 }
 
-enum minmea_sentence_id minmea_sentence_id(const char *sentence, bool strict)
+// Pack the three sentence type characters so the type can be switched on.
+#define MINMEA_TYPE(a, b, c) (((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
+
+enum minmea_sentence_id minmea_sentence_type(const char *sentence)
 {
-    if (!minmea_check(sentence, strict))
+    char type[6];
+    if (!minmea_field_t(sentence, type))
         return MINMEA_INVALID;
 
-    char type[6];
-    if (!minmea_scan(sentence, "t", type))
+    switch (MINMEA_TYPE(type[2], type[3], type[4])) {
+        case MINMEA_TYPE('R', 'M', 'C'):
+            return MINMEA_SENTENCE_RMC;
+        case MINMEA_TYPE('G', 'G', 'A'):
+            return MINMEA_SENTENCE_GGA;
+        case MINMEA_TYPE('G', 'S', 'A'):
+            return MINMEA_SENTENCE_GSA;
+        case MINMEA_TYPE('G', 'L', 'L'):
+            return MINMEA_SENTENCE_GLL;
+        case MINMEA_TYPE('G', 'S', 'T'):
+            return MINMEA_SENTENCE_GST;
+        case MINMEA_TYPE('G', 'S', 'V'):
+            return MINMEA_SENTENCE_GSV;
+        case MINMEA_TYPE('V', 'T', 'G'):
+            return MINMEA_SENTENCE_VTG;
+        case MINMEA_TYPE('Z', 'D', 'A'):
+            return MINMEA_SENTENCE_ZDA;
+        default:
+            return MINMEA_UNKNOWN;
+    }
+}
+
+enum minmea_sentence_id minmea_sentence_id(const char *sentence, bool strict)
+{
+    if (!minmea_check(sentence, strict))
         return MINMEA_INVALID;
 
-    if (!strcmp(type+2, "RMC"))
-        return MINMEA_SENTENCE_RMC;
-    if (!strcmp(type+2, "GGA"))
-        return MINMEA_SENTENCE_GGA;
-    if (!strcmp(type+2, "GSA"))
-        return MINMEA_SENTENCE_GSA;
-    if (!strcmp(type+2, "GLL"))
-        return MINMEA_SENTENCE_GLL;
-    if (!strcmp(type+2, "GST"))
-        return MINMEA_SENTENCE_GST;
-    if (!strcmp(type+2, "GSV"))
-        return MINMEA_SENTENCE_GSV;
-    if (!strcmp(type+2, "VTG"))
-        return MINMEA_SENTENCE_VTG;
-    if (!strcmp(type+2, "ZDA"))
-        return MINMEA_SENTENCE_ZDA;
-
-    return MINMEA_UNKNOWN;
+    return minmea_sentence_type(sentence);
 }
 
 bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence)
 {
     // $GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62
+    struct minmea_tokens t;
     char type[6];
     char validity;
     int latitude_direction;
     int longitude_direction;
     int variation_direction;
-    if (!minmea_scan(sentence, "tTcfdfdffDfd",
-            type,
-            &frame->time,
-            &validity,
-            &frame->latitude, &latitude_direction,
-            &frame->longitude, &longitude_direction,
-            &frame->speed,
-            &frame->course,
-            &frame->date,
-            &frame->variation, &variation_direction))
+
+    minmea_tokenize(&t, sentence, 12);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_T, &frame->time) &&
+          minmea_decode(&t, 2, minmea_field_c, &validity) &&
+          minmea_decode(&t, 3, minmea_field_f, &frame->latitude) &&
+          minmea_decode(&t, 4, minmea_field_d, &latitude_direction) &&
+          minmea_decode(&t, 5, minmea_field_f, &frame->longitude) &&
+          minmea_decode(&t, 6, minmea_field_d, &longitude_direction) &&
+          minmea_decode(&t, 7, minmea_field_f, &frame->speed) &&
+          minmea_decode(&t, 8, minmea_field_f, &frame->course) &&
+          minmea_decode(&t, 9, minmea_field_D, &frame->date) &&
+          minmea_decode(&t, 10, minmea_field_f, &frame->variation) &&
+          minmea_decode(&t, 11, minmea_field_d, &variation_direction)))
         return false;
     if (strcmp(type+2, "RMC"))
         return false;
@@ -411,21 +530,27 @@ bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence)
 bool minmea_parse_gga(struct minmea_sentence_gga *frame, const char *sentence)
 {
     // $GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
+    struct minmea_tokens t;
     char type[6];
     int latitude_direction;
     int longitude_direction;
 
-    if (!minmea_scan(sentence, "tTfdfdiiffcfcf_",
-            type,
-            &frame->time,
-            &frame->latitude, &latitude_direction,
-            &frame->longitude, &longitude_direction,
-            &frame->fix_quality,
-            &frame->satellites_tracked,
-            &frame->hdop,
-            &frame->altitude, &frame->altitude_units,
-            &frame->height, &frame->height_units,
-            &frame->dgps_age))
+    minmea_tokenize(&t, sentence, 15);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_T, &frame->time) &&
+          minmea_decode(&t, 2, minmea_field_f, &frame->latitude) &&
+          minmea_decode(&t, 3, minmea_field_d, &latitude_direction) &&
+          minmea_decode(&t, 4, minmea_field_f, &frame->longitude) &&
+          minmea_decode(&t, 5, minmea_field_d, &longitude_direction) &&
+          minmea_decode(&t, 6, minmea_field_i, &frame->fix_quality) &&
+          minmea_decode(&t, 7, minmea_field_i, &frame->satellites_tracked) &&
+          minmea_decode(&t, 8, minmea_field_f, &frame->hdop) &&
+          minmea_decode(&t, 9, minmea_field_f, &frame->altitude) &&
+          minmea_decode(&t, 10, minmea_field_c, &frame->altitude_units) &&
+          minmea_decode(&t, 11, minmea_field_f, &frame->height) &&
+          minmea_decode(&t, 12, minmea_field_c, &frame->height_units) &&
+          minmea_decode(&t, 13, minmea_field_f, &frame->dgps_age) &&
+          minmea_token_present(&t, 14)))
         return false;
     if (strcmp(type+2, "GGA"))
         return false;
@@ -439,27 +564,20 @@ bool minmea_parse_gga(struct minmea_sentence_gga *frame, const char *sentence)
 bool minmea_parse_gsa(struct minmea_sentence_gsa *frame, const char *sentence)
 {
     // $GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39
+    struct minmea_tokens t;
     char type[6];
 
-    if (!minmea_scan(sentence, "tciiiiiiiiiiiiifff",
-            type,
-            &frame->mode,
-            &frame->fix_type,
-            &frame->sats[0],
-            &frame->sats[1],
-            &frame->sats[2],
-            &frame->sats[3],
-            &frame->sats[4],
-            &frame->sats[5],
-            &frame->sats[6],
-            &frame->sats[7],
-            &frame->sats[8],
-            &frame->sats[9],
-            &frame->sats[10],
-            &frame->sats[11],
-            &frame->pdop,
-            &frame->hdop,
-            &frame->vdop))
+    minmea_tokenize(&t, sentence, 18);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_c, &frame->mode) &&
+          minmea_decode(&t, 2, minmea_field_i, &frame->fix_type)))
+        return false;
+    for (int i = 0; i < 12; i++)
+        if (!minmea_decode(&t, 3 + i, minmea_field_i, &frame->sats[i]))
+            return false;
+    if (!(minmea_decode(&t, 15, minmea_field_f, &frame->pdop) &&
+          minmea_decode(&t, 16, minmea_field_f, &frame->hdop) &&
+          minmea_decode(&t, 17, minmea_field_f, &frame->vdop)))
         return false;
     if (strcmp(type+2, "GSA"))
         return false;
@@ -470,17 +588,20 @@ bool minmea_parse_gsa(struct minmea_sentence_gsa *frame, const char *sentence)
 bool minmea_parse_gll(struct minmea_sentence_gll *frame, const char *sentence)
 {
     // $GPGLL,3723.2475,N,12158.3416,W,161229.487,A,A*41$;
+    struct minmea_tokens t;
     char type[6];
     int latitude_direction;
     int longitude_direction;
 
-    if (!minmea_scan(sentence, "tfdfdTc;c",
-            type,
-            &frame->latitude, &latitude_direction,
-            &frame->longitude, &longitude_direction,
-            &frame->time,
-            &frame->status,
-            &frame->mode))
+    minmea_tokenize(&t, sentence, 7);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_f, &frame->latitude) &&
+          minmea_decode(&t, 2, minmea_field_d, &latitude_direction) &&
+          minmea_decode(&t, 3, minmea_field_f, &frame->longitude) &&
+          minmea_decode(&t, 4, minmea_field_d, &longitude_direction) &&
+          minmea_decode(&t, 5, minmea_field_T, &frame->time) &&
+          minmea_decode(&t, 6, minmea_field_c, &frame->status) &&
+          minmea_decode(&t, 7, minmea_field_c, &frame->mode)))
         return false;
     if (strcmp(type+2, "GLL"))
         return false;
@@ -494,18 +615,19 @@ bool minmea_parse_gll(struct minmea_sentence_gll *frame, const char *sentence)
 bool minmea_parse_gst(struct minmea_sentence_gst *frame, const char *sentence)
 {
     // $GPGST,024603.00,3.2,6.6,4.7,47.3,5.8,5.6,22.0*58
+    struct minmea_tokens t;
     char type[6];
 
-    if (!minmea_scan(sentence, "tTfffffff",
-            type,
-            &frame->time,
-            &frame->rms_deviation,
-            &frame->semi_major_deviation,
-            &frame->semi_minor_deviation,
-            &frame->semi_major_orientation,
-            &frame->latitude_error_deviation,
-            &frame->longitude_error_deviation,
-            &frame->altitude_error_deviation))
+    minmea_tokenize(&t, sentence, 9);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_T, &frame->time) &&
+          minmea_decode(&t, 2, minmea_field_f, &frame->rms_deviation) &&
+          minmea_decode(&t, 3, minmea_field_f, &frame->semi_major_deviation) &&
+          minmea_decode(&t, 4, minmea_field_f, &frame->semi_minor_deviation) &&
+          minmea_decode(&t, 5, minmea_field_f, &frame->semi_major_orientation) &&
+          minmea_decode(&t, 6, minmea_field_f, &frame->latitude_error_deviation) &&
+          minmea_decode(&t, 7, minmea_field_f, &frame->longitude_error_deviation) &&
+          minmea_decode(&t, 8, minmea_field_f, &frame->altitude_error_deviation)))
         return false;
     if (strcmp(type+2, "GST"))
         return false;
@@ -520,31 +642,21 @@ bool minmea_parse_gsv(struct minmea_sentence_gsv *frame, const char *sentence)
     // $GPGSV,4,2,11,08,51,203,30,09,45,215,28*75
     // $GPGSV,4,4,13,39,31,170,27*40
     // $GPGSV,4,4,13*7B
+    struct minmea_tokens t;
     char type[6];
 
-    if (!minmea_scan(sentence, "tiii;iiiiiiiiiiiiiiii",
-            type,
-            &frame->total_msgs,
-            &frame->msg_nr,
-            &frame->total_sats,
-            &frame->sats[0].nr,
-            &frame->sats[0].elevation,
-            &frame->sats[0].azimuth,
-            &frame->sats[0].snr,
-            &frame->sats[1].nr,
-            &frame->sats[1].elevation,
-            &frame->sats[1].azimuth,
-            &frame->sats[1].snr,
-            &frame->sats[2].nr,
-            &frame->sats[2].elevation,
-            &frame->sats[2].azimuth,
-            &frame->sats[2].snr,
-            &frame->sats[3].nr,
-            &frame->sats[3].elevation,
-            &frame->sats[3].azimuth,
-            &frame->sats[3].snr
-            )) {
+    minmea_tokenize(&t, sentence, 4);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_i, &frame->total_msgs) &&
+          minmea_decode(&t, 2, minmea_field_i, &frame->msg_nr) &&
+          minmea_decode(&t, 3, minmea_field_i, &frame->total_sats)))
         return false;
+    for (int i = 0; i < 4; i++) {
+        if (!(minmea_decode(&t, 4 + 4*i, minmea_field_i, &frame->sats[i].nr) &&
+              minmea_decode(&t, 5 + 4*i, minmea_field_i, &frame->sats[i].elevation) &&
+              minmea_decode(&t, 6 + 4*i, minmea_field_i, &frame->sats[i].azimuth) &&
+              minmea_decode(&t, 7 + 4*i, minmea_field_i, &frame->sats[i].snr)))
+            return false;
     }
     if (strcmp(type+2, "GSV"))
         return false;
@@ -558,20 +670,21 @@ bool minmea_parse_vtg(struct minmea_sentence_vtg *frame, const char *sentence)
     // $GPVTG,156.1,T,140.9,M,0.0,N,0.0,K*41
     // $GPVTG,096.5,T,083.5,M,0.0,N,0.0,K,D*22
     // $GPVTG,188.36,T,,M,0.820,N,1.519,K,A*3F
+    struct minmea_tokens t;
     char type[6];
     char c_true, c_magnetic, c_knots, c_kph, c_faa_mode;
 
-    if (!minmea_scan(sentence, "tfcfcfcfc;c",
-            type,
-            &frame->true_track_degrees,
-            &c_true,
-            &frame->magnetic_track_degrees,
-            &c_magnetic,
-            &frame->speed_knots,
-            &c_knots,
-            &frame->speed_kph,
-            &c_kph,
-            &c_faa_mode))
+    minmea_tokenize(&t, sentence, 9);
+    if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+          minmea_decode(&t, 1, minmea_field_f, &frame->true_track_degrees) &&
+          minmea_decode(&t, 2, minmea_field_c, &c_true) &&
+          minmea_decode(&t, 3, minmea_field_f, &frame->magnetic_track_degrees) &&
+          minmea_decode(&t, 4, minmea_field_c, &c_magnetic) &&
+          minmea_decode(&t, 5, minmea_field_f, &frame->speed_knots) &&
+          minmea_decode(&t, 6, minmea_field_c, &c_knots) &&
+          minmea_decode(&t, 7, minmea_field_f, &frame->speed_kph) &&
+          minmea_decode(&t, 8, minmea_field_c, &c_kph) &&
+          minmea_decode(&t, 9, minmea_field_c, &c_faa_mode)))
         return false;
     if (strcmp(type+2, "VTG"))
         return false;
@@ -589,16 +702,17 @@ bool minmea_parse_vtg(struct minmea_sentence_vtg *frame, const char *sentence)
 bool minmea_parse_zda(struct minmea_sentence_zda *frame, const char *sentence)
 {
   // $GPZDA,201530.00,04,07,2002,00,00*60
+  struct minmea_tokens t;
   char type[6];
 
-  if(!minmea_scan(sentence, "tTiiiii",
-          type,
-          &frame->time,
-          &frame->date.day,
-          &frame->date.month,
-          &frame->date.year,
-          &frame->hour_offset,
-          &frame->minute_offset))
+  minmea_tokenize(&t, sentence, 7);
+  if (!(minmea_decode(&t, 0, minmea_field_t, type) &&
+        minmea_decode(&t, 1, minmea_field_T, &frame->time) &&
+        minmea_decode(&t, 2, minmea_field_i, &frame->date.day) &&
+        minmea_decode(&t, 3, minmea_field_i, &frame->date.month) &&
+        minmea_decode(&t, 4, minmea_field_i, &frame->date.year) &&
+        minmea_decode(&t, 5, minmea_field_i, &frame->hour_offset) &&
+        minmea_decode(&t, 6, minmea_field_i, &frame->minute_offset)))
       return false;
   if (strcmp(type+2, "ZDA"))
       return false;
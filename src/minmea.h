@@ -38,6 +38,8 @@ enum minmea_sentence_id {
     MINMEA_SENTENCE_ZDA,
 };
 
+#define MINMEA_SENTENCE_MASK(id) (1UL << (id))
+
 struct minmea_float {
     int_least32_t value;
     int_least32_t scale;
@@ -183,6 +185,12 @@ bool minmea_talker_id(char talker[3], const char *sentence);
  */
 enum minmea_sentence_id minmea_sentence_id(const char *sentence, bool strict);
 
+/**
+ * Determine sentence identifier from the talker and type bytes alone, without
+ * checking sentence validity or checksum.
+ */
+enum minmea_sentence_id minmea_sentence_type(const char *sentence);
+
 /**
  * Scanf-like processor for NMEA sentences. Supports the following formats:
  * c - single character (char *)
@@ -252,6 +260,31 @@ static inline float minmea_tocoord(struct minmea_float *f)
     return (float) degrees + (float) minutes / (60 * f->scale);
 }
 
+/**
+ * Convert a fixed-point value to an integer in units of num/den, e.g. 1000/1
+ * for metres to millimetres, without going through floating point.
+ * Returns 0 for "unknown" values.
+ */
+static inline int32_t minmea_toint(const struct minmea_float *f, int32_t num, int32_t den)
+{
+    if (f->scale == 0)
+        return 0;
+    return (int32_t) (((int64_t) f->value * num) / ((int64_t) f->scale * den));
+}
+
+/**
+ * Convert a raw coordinate to integer degrees scaled by 1e7 without going
+ * through floating point. Returns 0 for "unknown" values.
+ */
+static inline int32_t minmea_tocoord_e7(const struct minmea_float *f)
+{
+    if (f->scale == 0)
+        return 0;
+    int_least32_t degrees = f->value / (f->scale * 100);
+    int_least32_t minutes = f->value % (f->scale * 100);
+    return degrees * 10000000 + (int32_t) (((int64_t) minutes * 10000000) / ((int64_t) f->scale * 60));
+}
+
 #ifdef __cplusplus
 }
 #endif
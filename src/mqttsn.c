@@ -3,53 +3,180 @@
 // Includes
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "openthread/thread.h"
 #include "openthread/mqttsn.h"
 #include "openthread/link.h"
+#include "openthread/ip6.h"
 
-#include <zephyr/drivers/lora.h>
-#include <zephyr/lorawan/lorawan.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/net/openthread.h>
+#include <zephyr/random/rand32.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/util.h>
 
 #include "gpio.h"
-#include "app_bluetooth.h"
-#include "bluetooth/lns_client.h"
-
-#ifdef CONFIG_NRFX_TEMP
-#include <nrfx_temp.h>
-#endif
 
 #include "app.h"
+#include "channels.h"
+#include "telemetry.h"
+#include "telemetry_encode.h"
+#include "command.h"
+#include "delta.h"
+#include "uplink.h"
+#include "backoff.h"
 
 // Definitions
 
+#define BATCH_SAMPLES CONFIG_MQTT_SNCLIENT_BATCH_SAMPLES
+#define INFLIGHT_WINDOW CONFIG_MQTT_SNCLIENT_INFLIGHT_WINDOW
+
+// Completion table entries. Publications acknowledged behind an older one
+// stay in the table until it completes, but no longer count against the
+// window. Each entry covers at least one buffered sample, so a table the
+// size of the buffer only fills up once the buffer does.
+#define INFLIGHT_ENTRIES CONFIG_TELEMETRY_BUFFER_SAMPLES
+
+#if defined(CONFIG_MQTT_SNCLIENT_TELEMETRY_QOS0)
+#define TELEMETRY_QOS kQos0
+#else
+#define TELEMETRY_QOS kQos1
+#endif
+
+// Each delta batch is encoded against the state the gateway acknowledged
+#if defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA)
+BUILD_ASSERT(INFLIGHT_WINDOW == 1, "Delta payloads need one publication in flight");
+#endif
+
+#define PUBLISH_INTERVAL_MIN_S 1
+
+// A sleeping client wakes on the publish tick, so the interval has to stay
+// below the sleep duration announced to the gateway, or the gateway counts
+// the client as lost and drops the downlinks it buffered
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+#define SLEEP_DURATION_S CONFIG_MQTT_SNCLIENT_SLEEP_DURATION_S
+#define PUBLISH_INTERVAL_MAX_S (SLEEP_DURATION_S - 1)
+
+BUILD_ASSERT(PUBLISH_INTERVAL_S <= PUBLISH_INTERVAL_MAX_S,
+             "MQTT_SNCLIENT_SLEEP_DURATION_S must be longer than MQTT_SNCLIENT_PUBLISH_INTERVAL_S");
+#else
+#define PUBLISH_INTERVAL_MAX_S 86400
+#endif
+
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+#define ADAPTIVE_MAX_INTERVAL_S CONFIG_MQTT_SNCLIENT_ADAPTIVE_MAX_INTERVAL_S
+#endif
+
+#define SEARCH_BACKOFF_MIN_MS (CONFIG_MQTT_SNCLIENT_SEARCH_BACKOFF_MIN_S * 1000U)
+#define SEARCH_BACKOFF_MAX_MS (CONFIG_MQTT_SNCLIENT_SEARCH_BACKOFF_MAX_S * 1000U)
+
+BUILD_ASSERT(CONFIG_MQTT_SNCLIENT_SEARCH_BACKOFF_MIN_S <= CONFIG_MQTT_SNCLIENT_SEARCH_BACKOFF_MAX_S,
+             "The gateway search backoff minimum must not exceed the maximum");
+
+#if defined(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_SHORT)
+BUILD_ASSERT(sizeof(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_SHORT_NAME) == 3, "Short topic names are two characters");
+#endif
+#if defined(CONFIG_MQTT_SNCLIENT_SUB_TOPIC_SHORT)
+BUILD_ASSERT(sizeof(CONFIG_MQTT_SNCLIENT_SUB_TOPIC_SHORT_NAME) == 3, "Short topic names are two characters");
+#endif
+
+#if defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_BINARY)
+#define PAYLOAD_ENCODER telemetry_encoder_binary
+#define PAYLOAD_SIZE TELEMETRY_BINARY_SIZE(BATCH_SAMPLES)
+#elif defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA)
+#define PAYLOAD_ENCODER telemetry_encoder_delta
+#define PAYLOAD_SIZE TELEMETRY_DELTA_SIZE(BATCH_SAMPLES)
+#else
+#define PAYLOAD_ENCODER telemetry_encoder_json
+#define PAYLOAD_SIZE TELEMETRY_JSON_SIZE(BATCH_SAMPLES)
+#endif
+
+// Completion table entry for a publication in flight, covering a run of
+// telemetry sequence numbers. QoS0 publications complete when sent.
+struct mqttsnInflight {
+    uint16_t id;
+    uint16_t first;
+    uint16_t last;
+    bool acked;
+    int64_t sent;
+    otDeviceRole role;              // Reported state, confirmed on release
+    enum TriageStatus triage;
+};
+
+// Last gateway that reached STATE_RUNNING, persisted as mqttsn/gw
+struct mqttsnGateway {
+    otIp6Address address;
+    uint16_t port;
+    uint8_t gatewayId;
+    uint16_t topicId;               // Registered publication topic, 0 if unknown
+};
+
 // Enumerations
 
+// Driven by the Thread role and the MQTT-SN callbacks. Any failure on the way
+// to STATE_RUNNING, or a disconnection, goes back to STATE_SEARCHING.
 enum MQTTSN_CLIENT_STATE {
-    STATE_NONE = 0,
+    STATE_NONE = 0,                 // Not attached to a Thread network
     STATE_CONNECTING = 1,
     STATE_REGISTERING_PUB_TOPIC = 2,
-    STATE_SUBSCRIBING = 4,
+    STATE_SEARCHING = 3,            // SEARCHGW scheduled with backoff
     STATE_RUNNING = 5,
+    STATE_ASLEEP = 6,               // Sleeping client, gateway buffers downlinks
 };
 
 // Prototypes
 
 void mqttsnPublishHandler(struct k_timer *dummy);
+void mqttsnSearchWorkHandler(struct k_work *work);
+extern struct k_work mqttsnPublishWork;
 
 // Globals
 
+// The client state below is shared between the MQTT-SN callbacks, which run
+// on the OpenThread thread with the OpenThread API mutex held, and the work
+// handlers on the system work queue, which take the mutex for their whole
+// run.
+
 static char _eui64[16+1];
 
+BUILD_ASSERT(sizeof(_eui64) - 1 <= TELEMETRY_JSON_ID_LENGTH, "The JSON payload size allows for a 16 character ID");
+
 static otMqttsnTopic _aTopicPub;
 static K_TIMER_DEFINE(mqttsnPublishTimer, mqttsnPublishHandler, NULL);
+static uint32_t _publishIntervalS = PUBLISH_INTERVAL_S;
 static uint32_t _stateCount = 0;
 static enum MQTTSN_CLIENT_STATE _eMQTTSNClientState = STATE_NONE;
-
-int32_t whole_celsius = 0;
-uint8_t fraction_celsius = 0;
+static struct mqttsnInflight _inflight[INFLIGHT_ENTRIES];
+static size_t _inflightHead;
+static size_t _inflightCount;
+static size_t _inflightUnacked;         // QoS1 publications awaiting a PUBACK
+static uint16_t _messageId;
+static uint16_t _nextSeq;
+static bool _nextSeqValid;
+static otDeviceRole _lastRole = OT_DEVICE_ROLE_DISABLED;
+static enum TriageStatus _lastTriage = P0;
+static uint8_t _searchAttempts;
+static struct mqttsnGateway _gateway;
+static struct mqttsnGateway _gatewayCache;
+static bool _gatewayCached;
+static bool _directConnect;
+static bool _waking;
+static K_WORK_DELAYABLE_DEFINE(mqttsnSearchWork, mqttsnSearchWorkHandler);
+static uint8_t _payload[PAYLOAD_SIZE];
+#if defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA)
+// State acknowledged by the gateway, and the state after the batch in flight
+static struct delta_state _delta;
+static struct delta_state _deltaInFlight;
+#endif
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+static uint32_t _backoffS;
+static int64_t _lastReport;
+#endif
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+static int64_t _sleepStart;
+#endif
 
 // Functions
 
@@ -57,107 +184,380 @@ LOG_MODULE_REGISTER(mqttsn, CONFIG_MQTT_SNCLIENT_LOG_LEVEL);
 
 // Support functions
 
+static int mqttsnSettingsSet(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    if (!strcmp(name, "interval"))
+    {
+        uint32_t seconds;
+
+        if (len != sizeof(seconds) || read_cb(cb_arg, &seconds, len) != len)
+            return -EINVAL;
+        if (seconds < PUBLISH_INTERVAL_MIN_S || seconds > PUBLISH_INTERVAL_MAX_S)
+            return -EINVAL;
+
+        _publishIntervalS = seconds;
+        return 0;
+    }
+
+    if (strcmp(name, "gw"))
+        return -ENOENT;
+
+    if (len != sizeof(_gatewayCache) || read_cb(cb_arg, &_gatewayCache, len) != len)
+        return -EINVAL;
+
+    _gatewayCached = true;
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(mqttsn, "mqttsn", NULL, mqttsnSettingsSet, NULL, NULL);
+
+static void mqttsnSaveGateway(void)
+{
+    // Only write flash when something changed
+    if (_gatewayCached &&
+        otIp6IsAddressEqual(&_gatewayCache.address, &_gateway.address) &&
+        _gatewayCache.port == _gateway.port &&
+        _gatewayCache.gatewayId == _gateway.gatewayId &&
+        _gatewayCache.topicId == _gateway.topicId)
+        return;
+
+    _gatewayCache = _gateway;
+    _gatewayCached = true;
+
+    int err = settings_save_one("mqttsn/gw", &_gatewayCache, sizeof(_gatewayCache));
+    if (err)
+        LOG_WRN("Failed to save gateway: %d", err);
+}
+
+static void mqttsnForgetGateway(void)
+{
+    _gatewayCached = false;
+    settings_delete("mqttsn/gw");
+}
+
+static void mqttsnRunning(void)
+{
+    _eMQTTSNClientState = STATE_RUNNING;
+    _searchAttempts = 0;
+    _directConnect = false;
+    LOG_INF("MQTT-SN client running");
+    uplink_available(UPLINK_THREAD, true);
+
+    if (_aTopicPub.mType == kTopicId)
+        _gateway.topicId = _aTopicPub.mData.mTopicId;
+    mqttsnSaveGateway();
+
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+    // Poll quickly while exchanging messages with the gateway
+    otLinkSetPollPeriod(openthread_get_default_instance(), CONFIG_MQTT_SNCLIENT_ACTIVE_POLL_PERIOD_MS);
+#endif
+
+    k_work_submit(&mqttsnPublishWork);
+}
+
+static void mqttsnScheduleSearch(void)
+{
+    // Exponential backoff with jitter, so that nodes re-attaching together
+    // after a leader reboot spread their SEARCHGW multicasts out
+    uint32_t delay = backoff_delay_ms(SEARCH_BACKOFF_MIN_MS, SEARCH_BACKOFF_MAX_MS, _searchAttempts,
+                                      sys_rand32_get());
+
+    if(_searchAttempts < UINT8_MAX)
+        _searchAttempts++;
+    _eMQTTSNClientState = STATE_SEARCHING;
+    uplink_available(UPLINK_THREAD, false);
+
+    LOG_DBG("Searching for gateway in %d ms, attempt %d", delay, _searchAttempts);
+    k_work_reschedule(&mqttsnSearchWork, K_MSEC(delay));
+}
+
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+static void mqttsnSleep(otInstance *instance)
+{
+    LOG_DBG("Sleeping for up to %d s", SLEEP_DURATION_S);
+
+    // Set the state first so the disconnected handler expects the sleep ack
+    _eMQTTSNClientState = STATE_ASLEEP;
+    _sleepStart = k_uptime_get();
+    if (otMqttsnSleep(instance, SLEEP_DURATION_S) != OT_ERROR_NONE)
+    {
+        LOG_WRN("Failed to enter sleeping state");
+        _eMQTTSNClientState = STATE_RUNNING;
+        return;
+    }
+
+    // Nothing is expected until the next publish tick wakes us, so only
+    // poll the parent often enough to keep the child attached
+    otLinkSetPollPeriod(instance, CONFIG_MQTT_SNCLIENT_SLEEP_POLL_PERIOD_MS);
+}
+#endif
+
+static void mqttsnResetInflight(void)
+{
+    // Go back to the oldest unacknowledged sample. Anything acknowledged
+    // out of order behind it is sent again, and completions still due for
+    // the old publications no longer match an entry.
+    _inflightCount = 0;
+    _inflightUnacked = 0;
+    _nextSeqValid = false;
+}
+
+static void mqttsnConnect(otInstance *instance);
+
+static void mqttsnConnectionFailed(otInstance *instance)
+{
+    // Set the state first so the disconnected handler ignores our own disconnect
+    _eMQTTSNClientState = STATE_SEARCHING;
+    mqttsnResetInflight();
+    _waking = false;
+
+    // A cached gateway that does not answer is stale, rediscover it
+    if (_directConnect)
+    {
+        LOG_WRN("Cached gateway failed, falling back to discovery");
+        _directConnect = false;
+        mqttsnForgetGateway();
+    }
+
+    if(otMqttsnGetState(instance) != kStateDisconnected)
+        otMqttsnDisconnect(instance);
+
+    mqttsnScheduleSearch();
+}
+
+static const char *mqttsnTopicString(const otMqttsnTopic *aTopic, char *buffer, size_t size)
+{
+    switch(aTopic->mType)
+    {
+        case kTopicId:
+        case kPredefinedTopicId:
+            snprintf(buffer, size, "ID %d", aTopic->mData.mTopicId);
+            break;
+        case kShortTopicName:
+            snprintf(buffer, size, "short name %.2s", aTopic->mData.mShortTopicName);
+            break;
+        default:
+            snprintf(buffer, size, "name %s", aTopic->mData.mTopicName);
+            break;
+    }
+    return buffer;
+}
+
 static void mqttsnSubscribedHandler(otMqttsnReturnCode aCode, const otMqttsnTopic* aTopic, otMqttsnQos aQos, void* aContext)
 {
- // Handle registered
+    char topic[64];
+
+    // Sent alongside the first publication, so this does not gate publishing
     if (aCode == kCodeAccepted)
+        LOG_DBG("Subscribed OK %s", mqttsnTopicString(aTopic, topic, sizeof(topic)));
+    else
+        LOG_WRN("Subscribed Error %s", mqttsnTopicString(aTopic, topic, sizeof(topic)));
+}
+
+#if defined(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_NAME)
+static void mqttsnRegisterPubTopic(otInstance *instance);
+#endif
+
+static void mqttsnReleaseCompleted(void)
+{
+    // Release in publishing order, so an out of order PUBACK never releases
+    // the samples of an older publication that may still need resending
+    while (_inflightCount > 0 && _inflight[_inflightHead].acked)
     {
-        if(aTopic->mType == kTopicId || aTopic->mType == kPredefinedTopicId)
-            LOG_DBG("Subscribed OK ID %d", aTopic->mData.mTopicId);
-        else
-            LOG_DBG("Subscribed OK Name %s", aTopic->mData.mTopicName);
+        telemetry_release(_inflight[_inflightHead].last);
+
+        // The gateway has the state now. Until then a publication that is
+        // sent again still counts as a state change and goes at QoS1.
+        _lastRole = _inflight[_inflightHead].role;
+        _lastTriage = _inflight[_inflightHead].triage;
+#if defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA)
+        _delta = _deltaInFlight;
+#endif
+        _inflightHead = (_inflightHead + 1) % INFLIGHT_ENTRIES;
+        _inflightCount--;
     }
-    else
+}
+
+static struct mqttsnInflight *mqttsnFindInflight(uint16_t id)
+{
+    for (size_t i = 0; i < _inflightCount; i++)
     {
-        if(aTopic->mType == kTopicId || aTopic->mType == kPredefinedTopicId)
-            LOG_WRN("Subscribed Error ID %d", aTopic->mData.mTopicId);
-        else
-            LOG_WRN("Subscribed Error Name %s", aTopic->mData.mTopicName);
+        struct mqttsnInflight *entry = &_inflight[(_inflightHead + i) % INFLIGHT_ENTRIES];
+        if (entry->id == id)
+            return entry;
     }
+    return NULL;
 }
 
 static void mqttsnHandlePublished(otMqttsnReturnCode aCode, void* aContext)
 {
-    OT_UNUSED_VARIABLE(aCode);
-    OT_UNUSED_VARIABLE(aContext);
+    uint16_t id = (uint16_t)(uintptr_t)aContext;
+    struct mqttsnInflight *entry = mqttsnFindInflight(id);
+
+    if (entry == NULL)
+    {
+        LOG_DBG("Stale completion %d for message %u", aCode, id);
+        return;
+    }
+
+#if defined(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_NAME)
+    if (aCode == kCodeRejectedTopicId && _eMQTTSNClientState == STATE_RUNNING)
+    {
+        // The gateway no longer knows the cached topic ID
+        LOG_WRN("Publication topic ID rejected, registering again");
+        mqttsnResetInflight();
+        mqttsnRegisterPubTopic(openthread_get_default_instance());
+        return;
+    }
+#endif
+
+    if (aCode != kCodeAccepted)
+    {
+        // Samples stay buffered and are sent again on the next publish
+        LOG_WRN("Publish of message %u failed: %d, %zu samples pending", id, aCode, telemetry_pending());
+        mqttsnResetInflight();
+        return;
+    }
 
     // Handle published
-    LOG_INF("Published");
+    entry->acked = true;
+    _inflightUnacked--;
+    LOG_DBG("Message %u, samples %u to %u, acknowledged after %lld ms",
+        id, entry->first, entry->last, k_uptime_get() - entry->sent);
+    mqttsnReleaseCompleted();
+    LOG_INF("Published, %zu samples pending", telemetry_pending());
     otLedToggle(LED_YELLOW);
+
+    // Refill the window, draining any backlog without waiting for the timer
+    if (telemetry_pending() > 0)
+        k_work_submit(&mqttsnPublishWork);
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+    else if (_inflightCount == 0)
+        mqttsnSleep(openthread_get_default_instance());
+#endif
 }
 
+#if defined(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_NAME)
 static void mqttsnHandleRegistered(otMqttsnReturnCode aCode, const otMqttsnTopic* aTopic, void* aContext)
 {
-    // Handle registered - TODO: Fix support for short topic name
+    char topic[64];
+
+    // Handle registered
     if (aCode == kCodeAccepted)
-    {
-        if(aTopic->mType == kTopicId || aTopic->mType == kPredefinedTopicId)
-            LOG_DBG("Registered OK ID %d", aTopic->mData.mTopicId);
-        else
-            LOG_DBG("Registered OK Name %s", aTopic->mData.mTopicName);
-    }
+        LOG_DBG("Registered OK %s", mqttsnTopicString(aTopic, topic, sizeof(topic)));
     else
-    {
-        if(aTopic->mType == kTopicId || aTopic->mType == kPredefinedTopicId)
-            LOG_WRN("Registered Error ID %d", aTopic->mData.mTopicId);
-        else
-            LOG_WRN("Registered Error Name %s", aTopic->mData.mTopicName);
-    }
+        LOG_WRN("Registered Error %s", mqttsnTopicString(aTopic, topic, sizeof(topic)));
 
     otInstance *instance = (otInstance *)aContext;
 
-    switch(_eMQTTSNClientState)
+    if (_eMQTTSNClientState != STATE_REGISTERING_PUB_TOPIC)
     {
-        case STATE_NONE:
-        case STATE_CONNECTING:
-        case STATE_SUBSCRIBING:
-        case STATE_RUNNING:
-            LOG_WRN("Got invalid client state in registration handler: %d", _eMQTTSNClientState);
-            break;
+        LOG_WRN("Got invalid client state in registration handler: %d", _eMQTTSNClientState);
+        return;
+    }
 
-        case STATE_REGISTERING_PUB_TOPIC:
+    if (aCode != kCodeAccepted)
+    {
+        mqttsnConnectionFailed(instance);
+        return;
+    }
 
-            // We've done registering the Publication topic now Subscribe to the subscriptitopic
-            
-            otLedToggle(LED_YELLOW);
-            memcpy(&_aTopicPub, aTopic, sizeof(otMqttsnTopic));
+    otLedToggle(LED_YELLOW);
+    memcpy(&_aTopicPub, aTopic, sizeof(otMqttsnTopic));
+    mqttsnRunning();
+}
 
-            // Build topic
-            char data[128];
-            sprintf(data, "%s/%s/cmnd", TOPIC_PREFIX, _eui64);
+static void mqttsnRegisterPubTopic(otInstance *instance)
+{
+    // Build topic
+    char data[128];
+    sprintf(data, "%s/%s", TOPIC_PREFIX, _eui64);
 
-            otMqttsnTopic aTopicSub;
-            aTopicSub.mType = kTopicName;
-            aTopicSub.mData.mTopicName = data;
+    LOG_DBG("Registering Topic: %s", data);
+    otLedToggle(LED_YELLOW);
 
-            LOG_DBG("Subscribing to topic: %s", data);
-            otLedToggle(LED_YELLOW);
+    // Obtain target topic ID
+    _gateway.topicId = 0;
+    _eMQTTSNClientState = STATE_REGISTERING_PUB_TOPIC;
+    if (otMqttsnRegister(instance, data, mqttsnHandleRegistered, (void *)instance) != OT_ERROR_NONE)
+        mqttsnConnectionFailed(instance);
+}
+#endif
 
-            _eMQTTSNClientState = STATE_SUBSCRIBING;
-            otMqttsnSubscribe(instance, &aTopicSub, kQos0, mqttsnSubscribedHandler, (void *)instance);
-            break;
-    }
+static void mqttsnSubscribeCmdTopic(otInstance *instance)
+{
+#if defined(CONFIG_MQTT_SNCLIENT_SUB_TOPIC_PREDEFINED)
+    otMqttsnTopic aTopicSub = otMqttsnCreatePredefinedTopicId(CONFIG_MQTT_SNCLIENT_SUB_TOPIC_ID);
+#elif defined(CONFIG_MQTT_SNCLIENT_SUB_TOPIC_SHORT)
+    otMqttsnTopic aTopicSub = otMqttsnCreateShortTopicName(CONFIG_MQTT_SNCLIENT_SUB_TOPIC_SHORT_NAME);
+#else
+    // Build topic
+    char data[128];
+    sprintf(data, "%s/%s/cmnd", TOPIC_PREFIX, _eui64);
+
+    otMqttsnTopic aTopicSub = otMqttsnCreateTopicName(data);
+#endif
+    char topic[64];
+
+    LOG_DBG("Subscribing to topic: %s", mqttsnTopicString(&aTopicSub, topic, sizeof(topic)));
+    otLedToggle(LED_YELLOW);
+
+    otMqttsnSubscribe(instance, &aTopicSub, kQos0, mqttsnSubscribedHandler, (void *)instance);
 }
 
 static void mqttsnHandleConnected(otMqttsnReturnCode aCode, void* aContext)
 {
     // Handle connected
     otInstance *instance = (otInstance *)aContext;
+
+    if (_eMQTTSNClientState != STATE_CONNECTING)
+    {
+        LOG_WRN("Got invalid client state in connection handler: %d", _eMQTTSNClientState);
+        return;
+    }
+
     if (aCode == kCodeAccepted)
     {
         LOG_DBG("HandleConnected - Accepted");
         otLedToggle(LED_YELLOW);;
 
-        // Build topic
-        char data[128];
-        sprintf(data, "%s/%s", TOPIC_PREFIX, _eui64);
+        if (_waking)
+        {
+            // Back from sleep in the same session, the topic and the
+            // subscription are unchanged and buffered downlinks follow
+            _waking = false;
+            mqttsnRunning();
+            return;
+        }
+
+        // The subscription is pipelined with the first publication rather
+        // than holding it up for another round trip
+        mqttsnSubscribeCmdTopic(instance);
 
-        LOG_DBG("Registering Topic: %s", data);
-        otLedToggle(LED_YELLOW);
+#if defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA)
+        // This may be a different gateway, start it with a keyframe
+        delta_reset(&_delta);
+#endif
 
-        // Obtain target topic ID
-        _eMQTTSNClientState = STATE_REGISTERING_PUB_TOPIC;
-        otMqttsnRegister(instance, data, mqttsnHandleRegistered, (void *)instance);
+#if defined(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_PREDEFINED)
+        _aTopicPub = otMqttsnCreatePredefinedTopicId(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_ID);
+        mqttsnRunning();
+#elif defined(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_SHORT)
+        _aTopicPub = otMqttsnCreateShortTopicName(CONFIG_MQTT_SNCLIENT_PUB_TOPIC_SHORT_NAME);
+        mqttsnRunning();
+#else
+        if (_directConnect && _gateway.topicId != 0)
+        {
+            // The session is kept across connections, so the registered
+            // topic ID is still valid on the gateway
+            LOG_DBG("Reusing topic ID %d", _gateway.topicId);
+            _aTopicPub = otMqttsnCreateTopicId(_gateway.topicId);
+            mqttsnRunning();
+            return;
+        }
+
+        mqttsnRegisterPubTopic(instance);
+#endif
     }
     else
     {
@@ -178,50 +578,48 @@ static void mqttsnHandleConnected(otMqttsnReturnCode aCode, void* aContext)
                     LOG_WRN("HandleConnected - kCodeTimeout");
                     break;
         }
+
+        mqttsnConnectionFailed(instance);
     }
 }
 
-static otMqttsnReturnCode mqttsnHandlePublishReceived(const uint8_t* aPayload, int32_t aPayloadLength, const otMqttsnTopic* aTopic, void* aContext)
+static void mqttsnHandleDisconnected(otMqttsnDisconnectType aType, void* aContext)
 {
-    char buffer[128];
+    if (aType == kDisconnectAsleep && _eMQTTSNClientState == STATE_ASLEEP)
+    {
+        LOG_DBG("Gateway acknowledged sleep");
+        return;
+    }
 
-    memset(buffer, 0, sizeof(buffer));
+    LOG_WRN("Disconnected from gateway: %d", aType);
 
-    // Truncate to buffer as not zero terminated and we're going to log this data
-    if(aPayloadLength > sizeof(buffer))
-        aPayloadLength = sizeof(buffer)-1;
-    snprintf(buffer, aPayloadLength+1, "%s", aPayload);
+    // Nothing to do if detached, or if the disconnect came from a failure
+    // that already scheduled the next search
+    if (_eMQTTSNClientState == STATE_NONE || _eMQTTSNClientState == STATE_SEARCHING)
+        return;
 
-    if(aTopic->mType == kTopicId || aTopic->mType == kPredefinedTopicId)
-        LOG_DBG("Received message on topic ID %d: %s", aTopic->mData.mTopicId, buffer);
-    else
-        LOG_DBG("Registered message on topic name %s: %s", aTopic->mData.mTopicName, buffer);
+    // Unacknowledged batches are resent after reconnecting
+    mqttsnResetInflight();
+    mqttsnScheduleSearch();
+}
+
+static otMqttsnReturnCode mqttsnHandlePublishReceived(const uint8_t* aPayload, int32_t aPayloadLength, const otMqttsnTopic* aTopic, void* aContext)
+{
+    char topic[64];
+    LOG_DBG("Received %d bytes on topic %s", aPayloadLength, mqttsnTopicString(aTopic, topic, sizeof(topic)));
 
-    if(strstr(buffer, "identify") != NULL)
+    // Commands run later on the work queue, never in the OpenThread context
+    int err = command_submit(aPayload, aPayloadLength);
+    if (err)
     {
-        // TODO: Shouldn't really block but this should be called rarely...
-        LOG_INF("Identify board");
-        int cycles = 20;
-        while(cycles--)
-        {
-            otLedToggle(LED_YELLOW);
-	        k_sleep(K_MSEC(250));
-        }
+        LOG_WRN("Dropped command: %d", err);
+        return kCodeRejectedCongestion;
     }
     return kCodeAccepted;
 }
 
-static void mqttsnHandleSearchGw(const otIp6Address* aAddress, uint8_t aGatewayId, void* aContext)
+static void mqttsnConnect(otInstance *instance)
 {
-    OT_UNUSED_VARIABLE(aGatewayId);
-
-    LOG_DBG("Got search gateway response");
-     otLedToggle(LED_YELLOW);
-
-    // Handle SEARCHGW response received
-    // Connect to received address
-    otInstance *instance = (otInstance *)aContext;
-    otIp6Address address = *aAddress;
     // Set MQTT-SN client configuration settings
     otMqttsnConfig config;
 
@@ -229,45 +627,292 @@ static void mqttsnHandleSearchGw(const otIp6Address* aAddress, uint8_t aGatewayI
     char data[256];
     sprintf(data, "%s-%s", CLIENT_PREFIX, _eui64);
 
+    // Keep the session, and with it the registered topic ID and the command
+    // subscription, so a direct reconnect can skip straight to publishing
     config.mClientId = data;
     config.mKeepAlive = 30;
-    config.mCleanSession = true;
-    config.mPort = GATEWAY_MULTICAST_PORT;
-    config.mAddress = &address;
+    config.mCleanSession = false;
+    config.mPort = _gateway.port;
+    config.mAddress = &_gateway.address;
     config.mRetransmissionCount = 3;
     config.mRetransmissionTimeout = 10;
 
-    // Register connected callback
-    otMqttsnSetConnectedHandler(instance, mqttsnHandleConnected, (void *)instance);
-
-    // Register publish received callback
-    otMqttsnSetPublishReceivedHandler(instance, mqttsnHandlePublishReceived, (void *)instance);
-
     LOG_DBG("Trying to connect");
+    _eMQTTSNClientState = STATE_CONNECTING;
 
     // Connect to the MQTT broker (gateway)
-    otMqttsnConnect(instance, &config);
+    if (otMqttsnConnect(instance, &config) != OT_ERROR_NONE)
+        mqttsnConnectionFailed(instance);
 }
 
-void mqttsnSearchGateway(otInstance *instance)
+static void mqttsnHandleSearchGw(const otIp6Address* aAddress, uint8_t aGatewayId, void* aContext)
 {
+    // Several gateways, or the answers to other nodes' searches, can arrive
+    // for one search. Only the first is acted on.
+    if (_eMQTTSNClientState != STATE_SEARCHING)
+    {
+        LOG_DBG("Ignoring search gateway response in state %d", _eMQTTSNClientState);
+        return;
+    }
+
+    LOG_DBG("Got search gateway response");
+    otLedToggle(LED_YELLOW);
+
+    k_work_cancel_delayable(&mqttsnSearchWork);
+
+    // Handle SEARCHGW response received
+    // Connect to received address
+    _gateway.address = *aAddress;
+    _gateway.port = GATEWAY_MULTICAST_PORT;
+    _gateway.gatewayId = aGatewayId;
+    _gateway.topicId = 0;
+
+    mqttsnConnect((otInstance *)aContext);
+}
+
+static void mqttsnSearch(otInstance *instance)
+{
+    if (_eMQTTSNClientState != STATE_SEARCHING)
+        return;
+
+    // Try the last good gateway directly before any discovery traffic. A
+    // failure forgets it, so this only happens once per loss of the gateway.
+    if (_gatewayCached && _searchAttempts == 1)
+    {
+        LOG_DBG("Connecting to cached gateway %d", _gatewayCache.gatewayId);
+        _gateway = _gatewayCache;
+        _directConnect = true;
+        mqttsnConnect(instance);
+        return;
+    }
+
     otIp6Address address;
     otIp6AddressFromString(GATEWAY_MULTICAST_ADDRESS, &address);
 
     LOG_DBG("Searching for gateway on %s", GATEWAY_MULTICAST_ADDRESS);
     otLedToggle(LED_YELLOW);
 
-    otMqttsnSetSearchgwHandler(instance, mqttsnHandleSearchGw, (void *)instance);
     // Send SEARCHGW multicast message
     otMqttsnSearchGateway(instance, &address, GATEWAY_MULTICAST_PORT, GATEWAY_MULTICAST_RADIUS);
+
+    // Search again with a longer backoff if no gateway answers in time
+    mqttsnScheduleSearch();
 }
 
-void mqttsnPublishWorkHandler(struct k_work *work)
+void mqttsnSearchWorkHandler(struct k_work *work)
+{
+    struct openthread_context *context = openthread_get_default_context();
+
+    // A detach or disconnect on the OpenThread thread cannot interleave
+    // with a connect to the cached gateway
+    openthread_api_mutex_lock(context);
+    mqttsnSearch(context->instance);
+    openthread_api_mutex_unlock(context);
+}
+
+void mqttsnNetworkChanged(bool attached)
+{
+    if (!attached)
+    {
+        LOG_DBG("Detached, stopping gateway search");
+        _eMQTTSNClientState = STATE_NONE;
+        _searchAttempts = 0;
+        uplink_available(UPLINK_THREAD, false);
+        k_work_cancel_delayable(&mqttsnSearchWork);
+        return;
+    }
+
+    // Role changes between child, router and leader land here too. Only the
+    // first attach starts a search, later ones are already covered.
+    if (_eMQTTSNClientState == STATE_NONE)
+        mqttsnScheduleSearch();
+}
+
+// Encode a batch of samples, oldest first, into data. Returns the length,
+// 0 if it does not fit.
+static size_t mqttsnEncodeBatch(uint8_t *data, size_t size, const struct telemetry_sample *samples, size_t count)
+{
+    struct telemetry_encode_context context = {
+        .now = k_uptime_get(),
+        .id = _eui64,
+        .ages = true,
+    };
+
+#if defined(CONFIG_MQTT_SNCLIENT_PAYLOAD_DELTA)
+    // Encoded against the acknowledged state, so a batch that is sent
+    // again after a failed publish still decodes on the gateway
+    _deltaInFlight = _delta;
+    context.delta = &_deltaInFlight;
+#endif
+
+    return PAYLOAD_ENCODER.encode(&context, samples, count, data, size);
+}
+
+// State the gateway will have once everything in flight is acknowledged
+static void mqttsnReportedState(otDeviceRole *role, enum TriageStatus *triage)
 {
+    if (_inflightCount > 0)
+    {
+        const struct mqttsnInflight *newest = &_inflight[(_inflightHead + _inflightCount - 1) % INFLIGHT_ENTRIES];
+
+        *role = newest->role;
+        *triage = newest->triage;
+        return;
+    }
+
+    *role = _lastRole;
+    *triage = _lastTriage;
+}
+
+// Publish batches until the window or the completion table is full, or the
+// buffer is empty.
+// Returns the number of publications sent.
+static size_t mqttsnPublishWindow(otInstance *instance)
+{
+    size_t published = 0;
+
+    while(_inflightUnacked < INFLIGHT_WINDOW && _inflightCount < INFLIGHT_ENTRIES)
+    {
+        struct telemetry_sample samples[BATCH_SAMPLES];
+        size_t count = _nextSeqValid ?
+            telemetry_peek_from(_nextSeq, samples, BATCH_SAMPLES) :
+            telemetry_peek(samples, BATCH_SAMPLES);
+
+        if(count == 0)
+            break;
+
+        otLedToggle(LED_YELLOW);
+
+        // A batch that does not fit is sent as fewer samples
+        size_t length;
+        while((length = mqttsnEncodeBatch(_payload, sizeof(_payload), samples, count)) == 0 && count > 1)
+            count /= 2;
+
+        struct mqttsnInflight *entry = &_inflight[(_inflightHead + _inflightCount) % INFLIGHT_ENTRIES];
+
+        if(length == 0)
+        {
+            // Not even on its own, so drop the sample rather than retrying
+            // it on every tick. It is released in order behind the
+            // publications already in flight.
+            LOG_ERR("Sample %u does not fit in %zu bytes, dropped", samples[0].seq, sizeof(_payload));
+            otLedToggle(LED_YELLOW);
+
+            entry->id = 0;
+            entry->first = samples[0].seq;
+            entry->last = samples[0].seq;
+            entry->acked = true;
+            entry->sent = k_uptime_get();
+            mqttsnReportedState(&entry->role, &entry->triage);
+            _inflightCount++;
+            _nextSeq = entry->last + 1;
+            _nextSeqValid = true;
+            mqttsnReleaseCompleted();
+            continue;
+        }
+
+        // The role and triage status are those of the newest sample
+        otDeviceRole role = samples[count - 1].role;
+        enum TriageStatus triage_status = samples[count - 1].triage;
+
+        // Telemetry uses TELEMETRY_QOS, a change of role or triage status
+        // from what the gateway has acknowledged is always confirmed
+        bool stateChange = role != _lastRole || triage_status != _lastTriage;
+        otMqttsnQos qos = stateChange ? kQos1 : TELEMETRY_QOS;
+
+        entry->id = ++_messageId;
+        entry->first = samples[0].seq;
+        entry->last = samples[count - 1].seq;
+        entry->acked = qos == kQos0;
+        entry->sent = k_uptime_get();
+        entry->role = role;
+        entry->triage = triage_status;
+
+        // Publish message to the registered topic
+        LOG_INF("Publishing %zu of %zu samples as message %u, QoS %d...",
+            count, telemetry_pending(), entry->id, qos);
+
+        otError err = otMqttsnPublish(instance, _payload, length, qos, false, &_aTopicPub,
+            mqttsnHandlePublished, (void *)(uintptr_t)entry->id);
+
+        LOG_DBG("Publishing %zu bytes rsp %d", length, err);
+        otLedToggle(LED_YELLOW);
+
+        if(err != OT_ERROR_NONE)
+            break;
+
+        _inflightCount++;
+        if(qos == kQos1)
+            _inflightUnacked++;
+        uplink_sent(UPLINK_THREAD);
+        _nextSeq = entry->last + 1;
+        _nextSeqValid = true;
+        published++;
+
+        // QoS0 publications are complete once sent. Releasing them before
+        // the next batch lets it be encoded against their delta state.
+        mqttsnReleaseCompleted();
+    }
+
+    // Carry on with the backlog if the window has room again
+    if(published > 0 && _inflightUnacked < INFLIGHT_WINDOW && _inflightCount < INFLIGHT_ENTRIES &&
+       telemetry_pending() > 0)
+        k_work_submit(&mqttsnPublishWork);
+
+    return published;
+}
+
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+// The timer still ticks at the publish interval, but a tick only talks to
+// the gateway when samples are waiting. With the telemetry sampler dropping
+// unchanged samples, a stationary node then only checks in at an interval
+// that doubles up to ADAPTIVE_MAX_INTERVAL_S, and keeps its radio asleep
+// in between.
+static bool mqttsnReportDue(void)
+{
+    int64_t now = k_uptime_get();
+
+    if (telemetry_pending() > 0)
+        _backoffS = _publishIntervalS;
+    else if (now - _lastReport < (int64_t)_backoffS * MSEC_PER_SEC)
+        return false;
+    else
+        _backoffS = MIN(_backoffS * 2, MAX(ADAPTIVE_MAX_INTERVAL_S, _publishIntervalS));
+
+    _lastReport = now;
+    return true;
+}
+
+// A sleeping client has to wake before the sleep duration it announced
+// runs out, however far the adaptive backoff has grown. It wakes on the last
+// tick before then.
+static bool mqttsnWakeDue(void)
+{
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+    int64_t nextTick = k_uptime_get() + (int64_t)_publishIntervalS * MSEC_PER_SEC;
+
+    return _eMQTTSNClientState == STATE_ASLEEP &&
+        nextTick >= _sleepStart + (int64_t)SLEEP_DURATION_S * MSEC_PER_SEC;
+#else
+    return false;
+#endif
+}
+#endif
+
+static void mqttsnPublish(otInstance *instance)
+{
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+    if(!mqttsnWakeDue() && !mqttsnReportDue())
+    {
+        LOG_DBG("Nothing changed, next check-in within %u s", _backoffS);
+        k_timer_start(&mqttsnPublishTimer, K_SECONDS(_publishIntervalS), K_NO_WAIT);
+        return;
+    }
+#endif
+
 	LOG_DBG("Publish Handler %d", _stateCount);
     otLedToggle(LED_YELLOW);
 
-	otInstance *instance = openthread_get_default_instance();
     otMqttsnClientState state = otMqttsnGetState(instance);
 
     switch(state)
@@ -289,85 +934,85 @@ void mqttsnPublishWorkHandler(struct k_work *work)
             break;
     }
 
-    if(state == kStateDisconnected || otMqttsnGetState(instance)  == kStateLost)
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+    if(_eMQTTSNClientState == STATE_ASLEEP)
     {
-        LOG_WRN("MQTT g/w disconnected or lost: %d", otMqttsnGetState(instance) );
-        mqttsnSearchGateway(instance);
+        // Reconnect to become active again. The gateway then delivers
+        // anything it buffered while we slept, and RUNNING publishes.
+        LOG_DBG("Waking, %zu samples pending", telemetry_pending());
+        otLinkSetPollPeriod(instance, CONFIG_MQTT_SNCLIENT_ACTIVE_POLL_PERIOD_MS);
+        _waking = true;
+        mqttsnConnect(instance);
     }
     else
+#endif
+    if(_eMQTTSNClientState != STATE_RUNNING)
     {
-        static int count = 0;
-
-        LOG_DBG("Client state %d", otMqttsnGetState(instance));
-        otLedToggle(LED_YELLOW);
-
-        // Get RLOC16
-        uint16_t uRLOC16 = otLinkGetShortAddress(instance);
-
-#ifdef CONFIG_NRFX_TEMP
-        // Get temperature
-        nrfx_err_t status = nrfx_temp_measure();
-        if(status != NRFX_SUCCESS)
-            LOG_WRN("Error reading temperature: %d", status);
-            
-        int32_t temperature = nrfx_temp_result_get();
-        int32_t celsius_temperature = nrfx_temp_calculate(temperature);
-
-        whole_celsius = celsius_temperature / 100;
-        fraction_celsius = NRFX_ABS(celsius_temperature % 100);
-
-        LOG_INF("Measured temperature: %d.%02u [C]", whole_celsius, fraction_celsius);
+        LOG_DBG("Not publishing in client state %d, %zu samples pending", _eMQTTSNClientState, telemetry_pending());
+    }
+    else if(state == kStateDisconnected || state == kStateLost)
+    {
+        // Normally caught by the disconnected handler first
+        LOG_WRN("MQTT g/w disconnected or lost: %d", state);
+        mqttsnConnectionFailed(instance);
+    }
+    else if(mqttsnPublishWindow(instance) == 0 && _inflightCount == 0 && telemetry_pending() == 0)
+    {
+        LOG_DBG("Nothing to publish");
+#if defined(CONFIG_MQTT_SNCLIENT_SLEEP)
+        mqttsnSleep(instance);
 #endif
+    }
 
-        uint32_t latitude = 0;
-        uint32_t longitude = 0;
-        uint32_t elevation = 0;
+    // Restart timer
+    k_timer_start(&mqttsnPublishTimer, K_SECONDS(_publishIntervalS), K_NO_WAIT);
+}
 
-        uint8_t gps_lock = 0;
+void mqttsnPublishWorkHandler(struct k_work *work)
+{
+    struct openthread_context *context = openthread_get_default_context();
 
-        uint8_t battery = 100;
+    // Completions on the OpenThread thread update the in-flight window, so
+    // they must not run while a publication is being added to it
+    openthread_api_mutex_lock(context);
+    mqttsnPublish(context->instance);
+    openthread_api_mutex_unlock(context);
+}
 
-        const char* role = otThreadDeviceRoleToString(otThreadGetDeviceRole(instance));
-        char *triage_state = "P1";
+K_WORK_DEFINE(mqttsnPublishWork, mqttsnPublishWorkHandler);
 
-        // Publish message to the registered topic
-        LOG_INF("Publishing...");
+void mqttsnPublishHandler(struct k_timer *dummy)
+{
+    k_work_submit(&mqttsnPublishWork);
+}
 
-        otLedToggle(LED_YELLOW);
- 
-        const char* strdata = "{\"ID\":\"%s\", \"RLOC16\":\"%04X\", \"Version\":\"%d\", \"Count\":%d, \"Role\":\"%s\", \"Status\":\"%s\", \"Battery\":%d, \"GPSLock\": %d, \"Latitude\":%d, \"Longitude\":%d, \"Elevation\":%d, \"Temperature\":%d.%02u }";
-        char data[256];
-        sprintf(data, strdata, _eui64,
-            uRLOC16,
-            VERSION,
-		    count++,
-            role,
-            triage_state, 
-            battery,
-            gps_lock,
-            latitude,
-            longitude,
-            elevation,
-            whole_celsius, fraction_celsius 
-            );
-        
-        int32_t length = strlen(data);
+int mqttsnSetPublishInterval(uint32_t seconds)
+{
+    if (seconds < PUBLISH_INTERVAL_MIN_S || seconds > PUBLISH_INTERVAL_MAX_S)
+        return -EINVAL;
 
-        otError err = otMqttsnPublish(instance, (const uint8_t*)data, length, kQos1, false, &_aTopicPub,
-            mqttsnHandlePublished, NULL);
+    LOG_INF("Publish interval %u s", seconds);
+    _publishIntervalS = seconds;
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+    _backoffS = seconds;
+#endif
 
-        LOG_DBG("Publishing %d bytes rsp %d", length, err);
-        otLedToggle(LED_YELLOW);
-    }
+    int err = settings_save_one("mqttsn/interval", &_publishIntervalS, sizeof(_publishIntervalS));
+    if (err)
+        LOG_WRN("Failed to save publish interval: %d", err);
 
-    // Restart timer
-    k_timer_start(&mqttsnPublishTimer, K_SECONDS(10), K_NO_WAIT);
+    // Restart the timer so the new interval applies from now
+    k_timer_start(&mqttsnPublishTimer, K_SECONDS(_publishIntervalS), K_NO_WAIT);
+    return 0;
 }
 
-K_WORK_DEFINE(mqttsnPublishWork, mqttsnPublishWorkHandler);
-
-void mqttsnPublishHandler(struct k_timer *dummy)
+void mqttsnPublishNow(void)
 {
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+    // Check in even if nothing is waiting
+    _backoffS = _publishIntervalS;
+    _lastReport = k_uptime_get() - (int64_t)_backoffS * MSEC_PER_SEC;
+#endif
     k_work_submit(&mqttsnPublishWork);
 }
 
@@ -392,12 +1037,29 @@ otError mqttsnInit()
             extAddress.m8[6],
             extAddress.m8[7]
             );
+    LOG_INF("Client ID %s-%s", CLIENT_PREFIX, _eui64);
+
+    // Load the last good gateway for a direct reconnect
+    settings_subsys_init();
+    settings_load_subtree("mqttsn");
+    if (_gatewayCached)
+        LOG_INF("Cached gateway %d, topic ID %d", _gatewayCache.gatewayId, _gatewayCache.topicId);
+    LOG_INF("Publish interval %u s", _publishIntervalS);
+#if defined(CONFIG_MQTT_SNCLIENT_ADAPTIVE)
+    _backoffS = _publishIntervalS;
+#endif
+
+    // Register callbacks
+    otMqttsnSetSearchgwHandler(instance, mqttsnHandleSearchGw, (void *)instance);
+    otMqttsnSetConnectedHandler(instance, mqttsnHandleConnected, (void *)instance);
+    otMqttsnSetDisconnectedHandler(instance, mqttsnHandleDisconnected, (void *)instance);
+    otMqttsnSetPublishReceivedHandler(instance, mqttsnHandlePublishReceived, (void *)instance);
 
     otError error = otMqttsnStart(instance, CLIENT_PORT);
 
-    /* start one shot timer that expires after 10s */
+    /* start one shot timer that expires after the publish interval */
     if(error == OT_ERROR_NONE)
-        k_timer_start(&mqttsnPublishTimer, K_SECONDS(10), K_NO_WAIT);
+        k_timer_start(&mqttsnPublishTimer, K_SECONDS(_publishIntervalS), K_NO_WAIT);
 
     return error;
 }
\ No newline at end of file
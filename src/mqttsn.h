@@ -19,11 +19,21 @@
 
 #define TOPIC_PREFIX CONFIG_MQTT_SNCLIENT_TOPIC_PREFIX
 
-#define PUBLISH_INTERVAL_MS CONFIG_MQTT_SNCLIENT_PUBLISH_INTERVAL_S
+#define PUBLISH_INTERVAL_S CONFIG_MQTT_SNCLIENT_PUBLISH_INTERVAL_S
 
 // Prototypes
 
 otError mqttsnInit(void);
-void mqttsnSearchGateway(otInstance *instance);
+
+// Change the publish interval at runtime and keep it across reboots.
+// Returns -EINVAL if out of range.
+int mqttsnSetPublishInterval(uint32_t seconds);
+
+// Publish as soon as possible rather than waiting for the next tick
+void mqttsnPublishNow(void);
+
+// Tell the client whether the node is attached to a Thread network. The
+// gateway search starts, with backoff, on the first attach and stops on detach.
+void mqttsnNetworkChanged(bool attached);
 
 #endif
\ No newline at end of file
@@ -10,14 +10,11 @@
 #include "openthread/instance.h"
 #include "openthread/thread.h"
 
-#ifdef CONFIG_NRFX_TEMP
-#include "nrfx_temp.h"
-#endif
-
 #include "utils.h"
 #include "mqttsn.h"
 #include "app_bluetooth.h"
 #include "gpio.h"
+#include "channels.h"
 
 #if defined(CONFIG_CLI_SAMPLE_LOW_POWER)
 #include "low_power.h"
@@ -35,6 +32,16 @@ static void otStateChanged(otChangedFlags aFlags, void *aContext)
 {
     otInstance *instance = (otInstance *)aContext;
 
+    // Keep the telemetry view of the network current
+    if (aFlags & (OT_CHANGED_THREAD_ROLE | OT_CHANGED_THREAD_RLOC_ADDED))
+    {
+      struct network_status status = {
+          .role = otThreadGetDeviceRole(instance),
+          .rloc16 = otThreadGetRloc16(instance),
+      };
+      zbus_chan_pub(&network_chan, &status, K_NO_WAIT);
+    }
+
     // when thread role changed
     if (aFlags & OT_CHANGED_THREAD_ROLE)
     {
@@ -60,11 +67,8 @@ static void otStateChanged(otChangedFlags aFlags, void *aContext)
           break;
       }
 
-      // If role changed to any of active roles then send SEARCHGW message
-      if (role == OT_DEVICE_ROLE_CHILD || role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER)
-      {
-        mqttsnSearchGateway(instance);
-      }
+      // Any of the active roles lets the MQTT-SN client search for a gateway
+      mqttsnNetworkChanged(role == OT_DEVICE_ROLE_CHILD || role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER);
     }
 	else
 	{
@@ -174,14 +178,6 @@ void openthread_client_thread(void)
         low_power_enable();
     #endif
 
-    #ifdef CONFIG_NRFX_TEMP
-        // Initialise internal temperature reading
-        nrfx_err_t status;
-        nrfx_temp_config_t config = NRFX_TEMP_DEFAULT_CONFIG;
-        status = nrfx_temp_init(&config, NULL);
-        NRFX_ASSERT(status == NRFX_SUCCESS);
-    #endif
-
         // New code
         otInstance *instance;
         otError error = OT_ERROR_NONE;
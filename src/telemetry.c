@@ -0,0 +1,241 @@
+// Includes
+
+#include "telemetry.h"
+
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#include "app.h"
+#include "channels.h"
+#include "uplink.h"
+
+// Definitions
+
+#define SAMPLE_INTERVAL K_SECONDS(CONFIG_TELEMETRY_SAMPLE_INTERVAL_S)
+#define BUFFER_SAMPLES CONFIG_TELEMETRY_BUFFER_SAMPLES
+
+// There is no battery measurement yet, so a full battery is reported
+#define BATTERY_PERCENT 100
+
+#if defined(CONFIG_TELEMETRY_ADAPTIVE)
+// One metre is about 90 units of 1e-7 degrees of latitude. Longitude is
+// compared on the same scale, which overestimates east-west movement away
+// from the equator and only makes the filter keep more samples.
+#define DISTANCE_THRESHOLD ((int64_t)CONFIG_TELEMETRY_ADAPTIVE_DISTANCE_M * 90)
+#define TEMPERATURE_THRESHOLD CONFIG_TELEMETRY_ADAPTIVE_TEMPERATURE
+#define HEARTBEAT_MS ((int64_t)CONFIG_TELEMETRY_ADAPTIVE_HEARTBEAT_S * MSEC_PER_SEC)
+#endif
+
+LOG_MODULE_REGISTER(telemetry, CONFIG_TELEMETRY_LOG_LEVEL);
+
+// Globals
+
+// Store-and-forward ring. When full the oldest undelivered sample is
+// overwritten, so a long outage keeps the most recent history.
+static struct telemetry_sample _samples[BUFFER_SAMPLES];
+static size_t _head;
+static size_t _count;
+static uint16_t _nextSeq;
+static uint32_t _dropped;
+static struct k_spinlock _lock;
+static struct telemetry_sample _latest;
+static bool _latestValid;
+static atomic_t _priorityRequested;
+static atomic_t _sampleRequested;
+#if defined(CONFIG_TELEMETRY_ADAPTIVE)
+static struct telemetry_sample _lastBuffered;
+static bool _buffered;
+static uint32_t _skipped;
+#endif
+
+// Functions
+
+static void telemetry_push(const struct telemetry_sample *sample)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    if (_count == BUFFER_SAMPLES) {
+        _head = (_head + 1) % BUFFER_SAMPLES;
+        _count--;
+        _dropped++;
+    }
+
+    struct telemetry_sample *slot = &_samples[(_head + _count) % BUFFER_SAMPLES];
+    *slot = *sample;
+    slot->seq = _nextSeq++;
+    _count++;
+
+    k_spin_unlock(&_lock, key);
+}
+
+size_t telemetry_peek(struct telemetry_sample *samples, size_t max)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    size_t n = MIN(max, _count);
+    for (size_t i = 0; i < n; i++) {
+        samples[i] = _samples[(_head + i) % BUFFER_SAMPLES];
+    }
+
+    k_spin_unlock(&_lock, key);
+    return n;
+}
+
+size_t telemetry_peek_from(uint16_t seq, struct telemetry_sample *samples, size_t max)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    // Skip the samples before seq, wrapping like telemetry_release()
+    size_t skip = 0;
+    while (skip < _count && (int16_t)(_samples[(_head + skip) % BUFFER_SAMPLES].seq - seq) < 0) {
+        skip++;
+    }
+
+    size_t n = MIN(max, _count - skip);
+    for (size_t i = 0; i < n; i++) {
+        samples[i] = _samples[(_head + skip + i) % BUFFER_SAMPLES];
+    }
+
+    k_spin_unlock(&_lock, key);
+    return n;
+}
+
+void telemetry_release(uint16_t seq)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    // Sequence numbers wrap, so compare by distance from the oldest sample.
+    // Samples already overwritten while the batch was in flight are gone.
+    while (_count > 0 && (int16_t)(seq - _samples[_head].seq) >= 0) {
+        _head = (_head + 1) % BUFFER_SAMPLES;
+        _count--;
+    }
+
+    k_spin_unlock(&_lock, key);
+}
+
+bool telemetry_latest(struct telemetry_sample *sample)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    *sample = _latest;
+    bool valid = _latestValid;
+
+    k_spin_unlock(&_lock, key);
+    return valid;
+}
+
+size_t telemetry_pending(void)
+{
+    return _count;
+}
+
+uint32_t telemetry_dropped(void)
+{
+    return _dropped;
+}
+
+#if defined(CONFIG_TELEMETRY_ADAPTIVE)
+static bool telemetry_changed(const struct telemetry_sample *sample)
+{
+    const struct telemetry_sample *last = &_lastBuffered;
+
+    if (!_buffered || sample->position.valid != last->position.valid) {
+        return true;
+    }
+
+    // Role and triage changes are always reported
+    if (sample->role != last->role || sample->triage != last->triage) {
+        return true;
+    }
+
+    if (sample->timestamp - last->timestamp >= HEARTBEAT_MS) {
+        return true;
+    }
+
+    if (abs(sample->temperature - last->temperature) >= TEMPERATURE_THRESHOLD) {
+        return true;
+    }
+
+    return llabs((int64_t)sample->position.latitude - last->position.latitude) >= DISTANCE_THRESHOLD ||
+           llabs((int64_t)sample->position.longitude - last->position.longitude) >= DISTANCE_THRESHOLD;
+}
+#endif
+
+static void telemetry_sample_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(telemetry_sample_work, telemetry_sample_handler);
+
+static void telemetry_sample_handler(struct k_work *work)
+{
+    struct location_snapshot location;
+    struct temperature_sample temperature = { 0 };
+    struct network_status network = { 0 };
+    struct telemetry_sample sample = { 0 };
+
+    location_get(&location);
+    zbus_chan_read(&temperature_chan, &temperature, K_MSEC(100));
+    zbus_chan_read(&network_chan, &network, K_MSEC(100));
+
+    sample.timestamp = k_uptime_get();
+    sample.position = location.position;
+    sample.temperature = temperature.temperature;
+    sample.rloc16 = network.rloc16;
+    sample.role = network.role;
+    sample.triage = triage_status_get();
+    sample.battery = BATTERY_PERCENT;
+
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+    bool priority = atomic_set(&_priorityRequested, 0) ||
+        (_latestValid && sample.triage != _latest.triage);
+    _latest = sample;
+    _latestValid = true;
+    k_spin_unlock(&_lock, key);
+
+    // A triage status change, or a requested sample, is worth an uplink of
+    // its own
+    if (priority) {
+        uplink_priority();
+    }
+
+#if defined(CONFIG_TELEMETRY_ADAPTIVE)
+    // A requested sample is buffered whether or not anything changed, as
+    // the command that asked for it publishes straight after
+    bool requested = atomic_set(&_sampleRequested, 0);
+    if (!requested && !telemetry_changed(&sample)) {
+        _skipped++;
+        LOG_DBG("Unchanged, %u skipped", _skipped);
+        k_work_schedule(&telemetry_sample_work, SAMPLE_INTERVAL);
+        return;
+    }
+    _lastBuffered = sample;
+    _buffered = true;
+#endif
+
+    telemetry_push(&sample);
+    LOG_DBG("Sampled, %zu pending, %u dropped", telemetry_pending(), telemetry_dropped());
+
+    k_work_schedule(&telemetry_sample_work, SAMPLE_INTERVAL);
+}
+
+void telemetry_sample_now(bool priority)
+{
+    if (priority) {
+        atomic_set(&_priorityRequested, 1);
+    }
+    atomic_set(&_sampleRequested, 1);
+    k_work_reschedule(&telemetry_sample_work, K_NO_WAIT);
+}
+
+static int telemetry_init(void)
+{
+    k_work_schedule(&telemetry_sample_work, SAMPLE_INTERVAL);
+    return 0;
+}
+
+SYS_INIT(telemetry_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,55 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "location.h"
+
+// Timestamped sample taken by the telemetry sampler every
+// CONFIG_TELEMETRY_SAMPLE_INTERVAL_S, independent of any uplink. Every
+// reading is taken once here and shared by all uplinks, which encode it
+// with the encoders in telemetry_encode.h. With CONFIG_TELEMETRY_ADAPTIVE
+// only samples that changed are buffered.
+struct telemetry_sample {
+    uint16_t seq;                       // Consecutive, wraps
+    int64_t timestamp;                  // k_uptime_get() at sampling
+    struct location_position position;
+    int32_t temperature;                // 1/100 degrees C
+    uint16_t rloc16;
+    uint8_t role;                       // otDeviceRole
+    uint8_t triage;                     // enum TriageStatus
+    uint8_t battery;                    // Percent
+};
+
+// Copy up to max of the oldest buffered samples, oldest first, without
+// removing them. Returns the number copied.
+size_t telemetry_peek(struct telemetry_sample *samples, size_t max);
+
+// As telemetry_peek(), but starting at the first sample from seq onwards,
+// to read past samples that are already being delivered
+size_t telemetry_peek_from(uint16_t seq, struct telemetry_sample *samples, size_t max);
+
+// Remove buffered samples up to and including seq, once they have been
+// delivered. Samples pushed after a peek are not affected.
+void telemetry_release(uint16_t seq);
+
+// Copy the most recent sample taken, buffered or not, for uplinks that only
+// report the latest state. Returns false before the first sample.
+bool telemetry_latest(struct telemetry_sample *sample);
+
+// Take a sample now rather than at the next interval, e.g. after the
+// triage status changed. The sample is buffered even if the adaptive
+// filter would have skipped it. With priority it is signalled to the
+// uplinks as a priority message once taken. The sample is taken on the
+// system work queue, so work submitted there afterwards sees it.
+void telemetry_sample_now(bool priority);
+
+// Number of samples waiting to be delivered
+size_t telemetry_pending(void);
+
+// Number of samples overwritten before delivery since boot
+uint32_t telemetry_dropped(void);
+
+#endif
@@ -0,0 +1,154 @@
+// Includes
+
+#include "telemetry_encode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include "app.h"
+
+// Definitions
+
+// Same strings as otThreadDeviceRoleToString(), without depending on OpenThread
+static const char *const role_names[] = {
+    "disabled", "detached", "child", "router", "leader",
+};
+
+// Functions
+
+static uint16_t sample_age(const struct telemetry_encode_context *ctx,
+                           const struct telemetry_sample *sample)
+{
+    return MIN((ctx->now - sample->timestamp) / 1000, UINT16_MAX);
+}
+
+static size_t encode_json(const struct telemetry_encode_context *ctx,
+                          const struct telemetry_sample *samples, size_t count,
+                          uint8_t *data, size_t size)
+{
+    const struct telemetry_sample *newest = &samples[count - 1];
+    char *text = (char *)data;
+
+    int length = snprintf(text, size,
+        "{\"ID\":\"%s\", \"RLOC16\":\"%04X\", \"Version\":\"%d\", \"Count\":%d, \"Role\":\"%s\", \"Status\":\"P%d\", \"Battery\":%d, \"Samples\":[",
+        ctx->id,
+        newest->rloc16,
+        VERSION,
+        samples[0].seq,
+        newest->role < ARRAY_SIZE(role_names) ? role_names[newest->role] : "invalid",
+        newest->triage,
+        newest->battery);
+
+    for (size_t i = 0; i < count && length >= 0 && (size_t)length < size; i++) {
+        const struct location_position *position = &samples[i].position;
+
+        length += snprintf(text + length, size - length,
+            "%s{\"Age\":%d, \"GPSLock\": %d, \"Latitude\":%d, \"Longitude\":%d, \"Elevation\":%d, \"Speed\":%d, \"Temperature\":%s%d.%02u}",
+            i ? ", " : "",
+            sample_age(ctx, &samples[i]),
+            position->valid,
+            position->latitude,
+            position->longitude,
+            position->elevation / 1000,
+            position->speed,
+            // The sign on its own, or -0.50 C would print as 0.50
+            samples[i].temperature < 0 ? "-" : "",
+            abs(samples[i].temperature / 100), abs(samples[i].temperature % 100));
+    }
+
+    if (length >= 0 && (size_t)length < size) {
+        length += snprintf(text + length, size - length, "] }");
+    }
+
+    return (length >= 0 && (size_t)length < size) ? length : 0;
+}
+
+static size_t encode_binary(const struct telemetry_encode_context *ctx,
+                            const struct telemetry_sample *samples, size_t count,
+                            uint8_t *data, size_t size)
+{
+    const struct telemetry_sample *newest = &samples[count - 1];
+
+    if (size < TELEMETRY_BINARY_SIZE(count)) {
+        return 0;
+    }
+
+    // The ID is carried by the topic so is not repeated here
+    data[0] = VERSION;
+    sys_put_le16(samples[0].seq, &data[1]);
+    sys_put_le16(newest->rloc16, &data[3]);
+    data[5] = newest->role;
+    data[6] = newest->triage;
+    data[7] = newest->battery;
+    data[8] = count;
+
+    uint8_t *record = &data[TELEMETRY_BINARY_HEADER_SIZE];
+    for (size_t i = 0; i < count; i++, record += TELEMETRY_BINARY_SAMPLE_SIZE) {
+        const struct location_position *position = &samples[i].position;
+
+        sys_put_le16(sample_age(ctx, &samples[i]), &record[0]);
+        record[2] = position->valid ? 0x01 : 0x00;
+        sys_put_le32(position->latitude, &record[3]);
+        sys_put_le32(position->longitude, &record[7]);
+        sys_put_le16(CLAMP(position->elevation / 1000, INT16_MIN, INT16_MAX), &record[11]);
+        sys_put_le16(CLAMP(position->speed, 0, UINT16_MAX), &record[13]);
+        sys_put_le16(CLAMP(samples[i].temperature, INT16_MIN, INT16_MAX), &record[15]);
+    }
+
+    return record - data;
+}
+
+static size_t encode_delta(const struct telemetry_encode_context *ctx,
+                           const struct telemetry_sample *samples, size_t count,
+                           uint8_t *data, size_t size)
+{
+    uint8_t *record = data;
+
+    for (size_t i = 0; i < count; i++) {
+        struct delta_report report = {
+            .role = samples[i].role,
+            .triage = samples[i].triage,
+            .battery = samples[i].battery,
+            .rloc16 = samples[i].rloc16,
+            .position = samples[i].position,
+            .temperature = samples[i].temperature,
+        };
+        size_t left = size - (record - data);
+
+        if (ctx->ages) {
+            if (left < 2) {
+                return 0;
+            }
+            sys_put_le16(sample_age(ctx, &samples[i]), record);
+            record += 2;
+            left -= 2;
+        }
+
+        size_t length = delta_encode(ctx->delta, &report, samples[i].seq, record, left);
+        if (length == 0) {
+            return 0;
+        }
+        record += length;
+    }
+
+    return record - data;
+}
+
+const struct telemetry_encoder telemetry_encoder_json = {
+    .name = "json",
+    .encode = encode_json,
+};
+
+const struct telemetry_encoder telemetry_encoder_binary = {
+    .name = "binary",
+    .encode = encode_binary,
+};
+
+const struct telemetry_encoder telemetry_encoder_delta = {
+    .name = "delta",
+    .encode = encode_delta,
+};
@@ -0,0 +1,60 @@
+#ifndef TELEMETRY_ENCODE_H
+#define TELEMETRY_ENCODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "delta.h"
+#include "telemetry.h"
+
+// Payload encoders shared by the uplinks. They only depend on the samples
+// and the context, not on the transport, so an uplink picks one and the
+// same encoder can be built and exercised on the host.
+
+// Binary layout: 9 byte header followed by a 17 byte record per sample
+#define TELEMETRY_BINARY_HEADER_SIZE 9
+#define TELEMETRY_BINARY_SAMPLE_SIZE 17
+
+// JSON header and per sample sizes with every number at its widest, e.g. a
+// latitude of -2147483648, and an ID of up to TELEMETRY_JSON_ID_LENGTH
+// characters. Checked by the host tests.
+#define TELEMETRY_JSON_ID_LENGTH 16
+#define TELEMETRY_JSON_HEADER_SIZE 144
+#define TELEMETRY_JSON_SAMPLE_SIZE 152
+
+// Worst case payload sizes for count samples
+#define TELEMETRY_JSON_SIZE(count) (TELEMETRY_JSON_HEADER_SIZE + (count) * TELEMETRY_JSON_SAMPLE_SIZE)
+#define TELEMETRY_BINARY_SIZE(count) (TELEMETRY_BINARY_HEADER_SIZE + (count) * TELEMETRY_BINARY_SAMPLE_SIZE)
+#define TELEMETRY_DELTA_SIZE(count) ((count) * (2 + DELTA_MAX_SIZE))
+
+struct telemetry_encode_context {
+    int64_t now;                // k_uptime_get() at encoding, for sample ages
+    const char *id;             // Device ID, carried by JSON payloads
+    struct delta_state *delta;  // Delta encoder state, updated as records are written
+    bool ages;                  // Prefix each delta record with the sample age
+};
+
+// Encode count samples, oldest first, into data. The header fields (role,
+// RLOC16, triage status and battery) come from the newest sample. Returns
+// the payload length, or 0 if it does not fit in size.
+typedef size_t (*telemetry_encode_fn)(const struct telemetry_encode_context *ctx,
+                                      const struct telemetry_sample *samples, size_t count,
+                                      uint8_t *data, size_t size);
+
+struct telemetry_encoder {
+    const char *name;
+    telemetry_encode_fn encode;
+};
+
+// JSON object with a "Samples" array, as published by the MQTT-SN client
+// since version 3. The text is NUL terminated but the length excludes it.
+extern const struct telemetry_encoder telemetry_encoder_json;
+
+// Fixed little-endian layout, see scripts/decode_mqttsn.py
+extern const struct telemetry_encoder telemetry_encoder_binary;
+
+// One delta record per sample, see delta.h, optionally preceded by its age
+extern const struct telemetry_encoder telemetry_encoder_delta;
+
+#endif
@@ -0,0 +1,115 @@
+// Includes
+
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_NRFX_TEMP)
+#include <nrfx_temp.h>
+#endif
+
+#include "channels.h"
+
+// Definitions
+
+#define SAMPLE_INTERVAL K_SECONDS(CONFIG_TEMPERATURE_SAMPLE_INTERVAL_S)
+
+#if defined(CONFIG_TEMPERATURE_SIMULATED)
+// Triangle wave between 20 and 24 degrees C in 0.25 degree steps
+#define SIMULATED_MIN 2000
+#define SIMULATED_MAX 2400
+#define SIMULATED_STEP 25
+#endif
+
+LOG_MODULE_REGISTER(temperature, CONFIG_TEMPERATURE_LOG_LEVEL);
+
+// Globals
+
+#if defined(CONFIG_TEMPERATURE_SIMULATED)
+static int32_t _simulated = SIMULATED_MIN;
+static int32_t _simulatedStep = SIMULATED_STEP;
+#endif
+
+// Functions
+
+#if defined(CONFIG_TEMPERATURE_SIMULATED)
+
+static int temperatureSensorInit(void)
+{
+    return 0;
+}
+
+static int temperatureMeasure(int32_t *temperature)
+{
+    *temperature = _simulated;
+
+    if (_simulated + _simulatedStep > SIMULATED_MAX || _simulated + _simulatedStep < SIMULATED_MIN)
+        _simulatedStep = -_simulatedStep;
+    _simulated += _simulatedStep;
+
+    return 0;
+}
+
+#else
+
+static int temperatureSensorInit(void)
+{
+    nrfx_temp_config_t config = NRFX_TEMP_DEFAULT_CONFIG;
+    nrfx_err_t status = nrfx_temp_init(&config, NULL);
+
+    if (status != NRFX_SUCCESS) {
+        LOG_ERR("Failed to initialise temperature sensor: %d", status);
+        return -EIO;
+    }
+    return 0;
+}
+
+static int temperatureMeasure(int32_t *temperature)
+{
+    nrfx_err_t status = nrfx_temp_measure();
+
+    if (status != NRFX_SUCCESS) {
+        LOG_WRN("Error reading temperature: %d", status);
+        return -EIO;
+    }
+
+    *temperature = nrfx_temp_calculate(nrfx_temp_result_get());
+    return 0;
+}
+
+#endif
+
+static void temperatureSampleHandler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(temperatureSampleWork, temperatureSampleHandler);
+
+static void temperatureSampleHandler(struct k_work *work)
+{
+    struct temperature_sample sample;
+
+    if (temperatureMeasure(&sample.temperature) == 0) {
+        sample.timestamp = k_uptime_get();
+
+        LOG_DBG("Measured temperature: %d.%02u [C]", sample.temperature / 100,
+            abs(sample.temperature % 100));
+
+        zbus_chan_pub(&temperature_chan, &sample, K_MSEC(100));
+    }
+
+    k_work_schedule(&temperatureSampleWork, SAMPLE_INTERVAL);
+}
+
+static int temperatureInit(void)
+{
+    int err = temperatureSensorInit();
+
+    if (err)
+        return err;
+
+    k_work_schedule(&temperatureSampleWork, K_NO_WAIT);
+    return 0;
+}
+
+SYS_INIT(temperatureInit, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
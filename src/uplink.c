@@ -0,0 +1,225 @@
+// Includes
+
+#include "uplink.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+// Definitions
+
+#define FAILOVER_MS ((int64_t)CONFIG_UPLINK_FAILOVER_S * MSEC_PER_SEC)
+#define BUDGET_WINDOW_MS ((int64_t)3600 * MSEC_PER_SEC)
+#define INTERVAL_MIN_S 1
+#define INTERVAL_MAX_S 86400
+
+LOG_MODULE_REGISTER(uplink, CONFIG_UPLINK_LOG_LEVEL);
+
+struct uplink_state {
+    const char *name;
+    uint8_t cost;                   // Relative cost of a message
+    uint32_t interval_ms;           // Minimum between routine messages
+    uint16_t budget;                // Messages per hour, 0 for no limit
+    bool available;
+    int64_t changed;                // k_uptime_get() at the last availability change
+    int64_t last_sent;
+    int64_t window_start;
+    uint16_t used;                  // Messages in the current budget window
+    uint32_t sent;                  // Messages since boot
+};
+
+// Globals
+
+static struct uplink_state _links[UPLINK_COUNT] = {
+    [UPLINK_THREAD] = {
+        .name = "thread",
+        .cost = 1,
+    },
+    [UPLINK_LORAWAN] = {
+        .name = "lorawan",
+        .cost = 10,
+        .interval_ms = CONFIG_UPLINK_LORAWAN_INTERVAL_S * MSEC_PER_SEC,
+        .budget = CONFIG_UPLINK_LORAWAN_BUDGET,
+    },
+};
+static enum uplink_link _route = UPLINK_COUNT;
+static struct k_spinlock _lock;
+static atomic_t _priority;
+static struct k_work_q *_priorityQueue;
+static struct k_work_delayable *_priorityWork;
+
+// Functions
+
+// Intervals set by command are kept as "uplink/<link name>"
+static int uplink_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    for (enum uplink_link link = 0; link < UPLINK_COUNT; link++) {
+        uint32_t seconds;
+
+        if (strcmp(name, _links[link].name)) {
+            continue;
+        }
+        if (len != sizeof(seconds) || read_cb(cb_arg, &seconds, len) != len) {
+            return -EINVAL;
+        }
+        if (seconds < INTERVAL_MIN_S || seconds > INTERVAL_MAX_S) {
+            return -EINVAL;
+        }
+
+        _links[link].interval_ms = seconds * MSEC_PER_SEC;
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(uplink, "uplink", NULL, uplink_settings_set, NULL, NULL);
+
+static bool uplink_within_budget(struct uplink_state *state, int64_t now)
+{
+    if (now - state->window_start >= BUDGET_WINDOW_MS) {
+        state->window_start = now;
+        state->used = 0;
+    }
+
+    return state->budget == 0 || state->used < state->budget;
+}
+
+// A link that went down is still counted as up for FAILOVER_MS, so the
+// others do not take over during a brief outage. Links start down at boot,
+// which gives Thread the same grace period to attach.
+static bool uplink_up(const struct uplink_state *state, int64_t now)
+{
+    return state->available || now - state->changed < FAILOVER_MS;
+}
+
+// Cheapest link that is up and within budget, UPLINK_COUNT if none
+static enum uplink_link uplink_select(int64_t now)
+{
+    enum uplink_link best = UPLINK_COUNT;
+
+    for (enum uplink_link link = 0; link < UPLINK_COUNT; link++) {
+        struct uplink_state *state = &_links[link];
+
+        if (!uplink_up(state, now) || !uplink_within_budget(state, now)) {
+            continue;
+        }
+        if (best == UPLINK_COUNT || state->cost < _links[best].cost) {
+            best = link;
+        }
+    }
+
+    return best;
+}
+
+void uplink_available(enum uplink_link link, bool available)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    if (_links[link].available != available) {
+        _links[link].available = available;
+        _links[link].changed = k_uptime_get();
+    }
+
+    k_spin_unlock(&_lock, key);
+}
+
+bool uplink_route(enum uplink_link link, bool priority)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    int64_t now = k_uptime_get();
+    struct uplink_state *state = &_links[link];
+    enum uplink_link route = uplink_select(now);
+    bool send;
+
+    if (!state->available || !uplink_within_budget(state, now)) {
+        send = false;
+    } else if (priority) {
+        send = true;
+    } else {
+        send = route == link && (state->sent == 0 || now - state->last_sent >= state->interval_ms);
+    }
+
+    bool changed = route != _route;
+    _route = route;
+
+    k_spin_unlock(&_lock, key);
+
+    if (changed) {
+        LOG_INF("Routing telemetry over %s", route < UPLINK_COUNT ? _links[route].name : "nothing");
+    }
+
+    return send;
+}
+
+int uplink_set_interval(enum uplink_link link, uint32_t seconds)
+{
+    if (seconds < INTERVAL_MIN_S || seconds > INTERVAL_MAX_S) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+    _links[link].interval_ms = seconds * MSEC_PER_SEC;
+    k_spin_unlock(&_lock, key);
+
+    LOG_INF("Minimum interval over %s %u s", _links[link].name, seconds);
+
+    char key_name[16];
+    snprintk(key_name, sizeof(key_name), "uplink/%s", _links[link].name);
+    int err = settings_save_one(key_name, &seconds, sizeof(seconds));
+    if (err) {
+        LOG_WRN("Failed to save %s interval: %d", _links[link].name, err);
+    }
+    return 0;
+}
+
+void uplink_sent(enum uplink_link link)
+{
+    k_spinlock_key_t key = k_spin_lock(&_lock);
+
+    struct uplink_state *state = &_links[link];
+    int64_t now = k_uptime_get();
+
+    uplink_within_budget(state, now);
+    state->last_sent = now;
+    state->used++;
+    state->sent++;
+
+    k_spin_unlock(&_lock, key);
+
+    LOG_DBG("Sent over %s, %u this hour, %u since boot", state->name, state->used, state->sent);
+}
+
+void uplink_priority(void)
+{
+    atomic_set(&_priority, 1);
+    if (_priorityWork) {
+        k_work_reschedule_for_queue(_priorityQueue, _priorityWork, K_NO_WAIT);
+    }
+}
+
+void uplink_priority_work(struct k_work_q *queue, struct k_work_delayable *work)
+{
+    _priorityQueue = queue;
+    _priorityWork = work;
+}
+
+bool uplink_priority_take(void)
+{
+    return atomic_set(&_priority, 0) != 0;
+}
+
+static int uplink_init(void)
+{
+    settings_subsys_init();
+    settings_load_subtree("uplink");
+    return 0;
+}
+
+SYS_INIT(uplink_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
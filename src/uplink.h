@@ -0,0 +1,45 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+// Routes telemetry between the uplinks. Routine samples go over the
+// cheapest link that is up and within its budget, so LoRaWAN stays quiet
+// while the MQTT-SN client has a gateway. A link that goes down is only
+// given up on after CONFIG_UPLINK_FAILOVER_S, so a brief gateway search
+// does not spend LoRaWAN airtime. Priority messages go over every link
+// that is up and has budget left.
+enum uplink_link {
+    UPLINK_THREAD = 0,      // MQTT-SN over Thread
+    UPLINK_LORAWAN,
+    UPLINK_COUNT,
+};
+
+// Report whether a link can deliver messages, e.g. the MQTT-SN client has
+// a gateway or the LoRaWAN stack has joined
+void uplink_available(enum uplink_link link, bool available);
+
+// Whether link should carry the current message now. Routine messages
+// also respect the minimum interval of the link.
+bool uplink_route(enum uplink_link link, bool priority);
+
+// Set the minimum interval between routine messages over link, from 1 s to
+// a day, and keep it in settings. It starts out as set in Kconfig, e.g.
+// CONFIG_UPLINK_LORAWAN_INTERVAL_S. Returns -EINVAL if out of range.
+int uplink_set_interval(enum uplink_link link, uint32_t seconds);
+
+// Account for a message sent over link against its budget
+void uplink_sent(enum uplink_link link);
+
+// Signal a priority message, e.g. a triage status change. The work given
+// to uplink_priority_work() is rescheduled on queue to run straight away.
+void uplink_priority(void);
+void uplink_priority_work(struct k_work_q *queue, struct k_work_delayable *work);
+
+// Whether a priority message is due, clearing it
+bool uplink_priority_take(void);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * EU868 time on air and duty cycle accounting tests.
+ *
+ * Time on air is checked against a floating point transcription of the
+ * Semtech AN1200.13 formula at every data rate and PHY payload length, and
+ * against figures from the Semtech LoRa calculator. The tracker is checked
+ * for its rounding and for keeping a busy sender within the duty cycle.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zephyr/sys/util.h>
+
+#include "airtime.h"
+#include "check.h"
+
+#define HOUR_MS (3600 * 1000LL)
+
+// Largest EU868 FRMPayload
+#define MAX_PAYLOAD 242
+
+// Semtech AN1200.13 with an 8 symbol preamble, explicit header, CRC on
+// and coding rate 4/5, in seconds
+static double reference_lora(int sf, double bandwidth, size_t length)
+{
+    double symbol = pow(2, sf) / bandwidth;
+    int de = symbol > 0.016 ? 1 : 0;
+    double blocks = ceil((8.0 * length - 4.0 * sf + 28 + 16) / (4.0 * (sf - 2 * de)));
+
+    return (8 + 4.25 + 8 + MAX(blocks * 5, 0)) * symbol;
+}
+
+static double reference(uint8_t dr, size_t length)
+{
+    if (dr <= 5) {
+        return reference_lora(12 - dr, 125e3, length);
+    }
+    if (dr == 6) {
+        return reference_lora(7, 250e3, length);
+    }
+    // 50 kbit/s FSK with 5 bytes of preamble, 3 of sync word, a length
+    // byte and a 2 byte CRC
+    return (length + 11) * 8 / 50e3;
+}
+
+static void test_formula(void)
+{
+    for (uint8_t dr = 0; dr <= 7; dr++) {
+        uint32_t previous = 0;
+
+        for (size_t length = 0; length <= 255; length++) {
+            uint32_t toa = airtime_phy_us(dr, length);
+            double expected = reference(dr, length) * 1e6;
+
+            // Integer microseconds, truncated
+            if (fabs(toa - expected) >= 1) {
+                fprintf(stderr, "DR%u %zu bytes: %u us, expected %.1f us\n", dr, length, toa, expected);
+                check_failures++;
+            }
+            CHECK(toa >= previous);
+            previous = toa;
+        }
+    }
+}
+
+// Figures from the Semtech LoRa calculator for a PHY payload
+static void test_calculator(void)
+{
+    // 51 bytes of FRMPayload, the DR0 maximum, 2793.5 ms
+    CHECK_EQ(airtime_phy_us(0, 64), 2793472);
+    CHECK_EQ(airtime_us(0, 51), 2793472);
+
+    // Empty uplinks at SF12 and SF7, 1155.1 ms and 46.3 ms
+    CHECK_EQ(airtime_us(0, 0), 1155072);
+    CHECK_EQ(airtime_us(5, 0), 46336);
+
+    // The largest FRMPayload at SF7 125 kHz and 250 kHz, 399.6 ms and 199.8 ms
+    CHECK_EQ(airtime_us(5, 242), 399616);
+    CHECK_EQ(airtime_us(6, 242), 199808);
+
+    // Join requests, the slowest and fastest LoRa rates
+    CHECK_EQ(airtime_phy_us(0, AIRTIME_JOIN_REQUEST_SIZE), 1482752);
+    CHECK_EQ(airtime_phy_us(5, AIRTIME_JOIN_REQUEST_SIZE), 61696);
+
+    // FSK, 160 us a byte
+    CHECK_EQ(airtime_us(7, 10), (10 + 13 + 11) * 160);
+
+    // No such data rate
+    CHECK_EQ(airtime_phy_us(8, 10), 0);
+    CHECK_EQ(airtime_us(15, 10), 0);
+}
+
+static void test_join_duty_cycle(void)
+{
+    CHECK_EQ(airtime_join_duty_cycle(0), 100);
+    CHECK_EQ(airtime_join_duty_cycle(HOUR_MS - 1), 100);
+    CHECK_EQ(airtime_join_duty_cycle(HOUR_MS), 1000);
+    CHECK_EQ(airtime_join_duty_cycle(11 * HOUR_MS - 1), 1000);
+    CHECK_EQ(airtime_join_duty_cycle(11 * HOUR_MS), 10000);
+    CHECK_EQ(airtime_join_duty_cycle(1000 * HOUR_MS), 10000);
+}
+
+static void test_tracker(void)
+{
+    struct airtime_tracker tracker = { .duty_cycle = 100 };
+
+    CHECK(airtime_ready(&tracker, 0));
+    CHECK_EQ(airtime_wait(&tracker, 0), 0);
+
+    // 46.336 ms at 1% is 4633.6 ms off, rounded up
+    airtime_sent(&tracker, 1000, 46336);
+    CHECK_EQ(tracker.next, 1000 + 4634);
+    CHECK(!airtime_ready(&tracker, 5633));
+    CHECK(airtime_ready(&tracker, 5634));
+    CHECK_EQ(airtime_wait(&tracker, 5000), 634);
+    CHECK_EQ(airtime_wait(&tracker, 9000), 0);
+
+    // Whole milliseconds are not rounded up
+    airtime_sent(&tracker, 10000, 20000);
+    CHECK_EQ(tracker.next, 12000);
+
+    CHECK_EQ(tracker.total_us, 46336 + 20000);
+    CHECK_EQ(tracker.frames, 2);
+}
+
+// A sender that transmits whenever the band is free, with frames of random
+// length and data rate, stays within the duty cycle over any hour, but for
+// the last frame it starts in that hour
+static void test_busy_sender(void)
+{
+    const uint16_t duty_cycles[] = { 100, 1000, 10000 };
+
+    srand(23);
+    for (size_t d = 0; d < ARRAY_SIZE(duty_cycles); d++) {
+        struct airtime_tracker tracker = { .duty_cycle = duty_cycles[d] };
+        static int64_t sent[100000];
+        static uint32_t toa[100000];
+        size_t frames = 0;
+
+        for (int64_t now = 0; now < 24 * HOUR_MS && frames < ARRAY_SIZE(sent); now += 100) {
+            if (airtime_ready(&tracker, now)) {
+                toa[frames] = airtime_us(rand() % 8, rand() % (MAX_PAYLOAD + 1));
+                sent[frames] = now;
+                airtime_sent(&tracker, now, toa[frames]);
+                frames++;
+            }
+        }
+        CHECK(frames > 0);
+        CHECK_EQ(tracker.frames, frames);
+
+        // Time on air in the hour starting at each frame
+        size_t last = 0;
+        uint64_t window_us = 0;
+        for (size_t first = 0; first < frames; first++) {
+            while (last < frames && sent[last] < sent[first] + HOUR_MS) {
+                window_us += toa[last++];
+            }
+            if (window_us - toa[last - 1] > HOUR_MS * 1000 / duty_cycles[d]) {
+                fprintf(stderr, "1/%u: %llu us on air in the hour from %lld ms\n", duty_cycles[d],
+                        (unsigned long long)window_us, (long long)sent[first]);
+                check_failures++;
+                break;
+            }
+            window_us -= toa[first];
+        }
+    }
+}
+
+int main(void)
+{
+    test_formula();
+    test_calculator();
+    test_join_duty_cycle();
+    test_tracker();
+    test_busy_sender();
+
+    return check_result();
+}
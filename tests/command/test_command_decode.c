@@ -0,0 +1,107 @@
+/*
+ * Binary downlink command decoding tests.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "check.h"
+#include "command.h"
+
+// The smallest CONFIG_COMMAND_MAX_LENGTH allows
+#define TEXT_SIZE (24 + 1)
+
+static void check_decode(const uint8_t *data, size_t length, const char *expected)
+{
+    char text[TEXT_SIZE];
+
+    CHECK_EQ(command_decode(data, length, text, sizeof(text)), 0);
+    CHECK(strcmp(text, expected) == 0);
+}
+
+static void test_opcodes(void)
+{
+    check_decode((const uint8_t[]){ COMMAND_OP_IDENTIFY }, 1, "identify");
+    check_decode((const uint8_t[]){ COMMAND_OP_INTERVAL, 0x3c, 0x00, 0x00, 0x00 }, 5, "interval 60");
+    check_decode((const uint8_t[]){ COMMAND_OP_INTERVAL, 0x01, 0x02, 0x03, 0x04 }, 5, "interval 67305985");
+    check_decode((const uint8_t[]){ COMMAND_OP_INTERVAL, 0xff, 0xff, 0xff, 0xff }, 5, "interval 4294967295");
+    check_decode((const uint8_t[]){ COMMAND_OP_TRIAGE, 0x02 }, 2, "triage 2");
+    check_decode((const uint8_t[]){ COMMAND_OP_REBOOT }, 1, "reboot");
+    check_decode((const uint8_t[]){ COMMAND_OP_STATE }, 1, "state");
+    check_decode((const uint8_t[]){ COMMAND_OP_POSITION }, 1, "position");
+    check_decode((const uint8_t[]){ COMMAND_OP_CLASS, 0x02 }, 2, "class 2");
+}
+
+static void test_malformed(void)
+{
+    char text[TEXT_SIZE];
+
+    CHECK_EQ(command_decode((const uint8_t[]){ 0 }, 0, text, sizeof(text)), -EINVAL);
+
+    // Argument too short or too long for the opcode
+    CHECK_EQ(command_decode((const uint8_t[]){ COMMAND_OP_INTERVAL, 0x3c }, 2, text, sizeof(text)), -EINVAL);
+    CHECK_EQ(command_decode((const uint8_t[]){ COMMAND_OP_IDENTIFY, 0x00 }, 2, text, sizeof(text)), -EINVAL);
+    CHECK_EQ(command_decode((const uint8_t[]){ COMMAND_OP_TRIAGE }, 1, text, sizeof(text)), -EINVAL);
+
+    CHECK_EQ(command_decode((const uint8_t[]){ 0x00 }, 1, text, sizeof(text)), -ENOENT);
+    CHECK_EQ(command_decode((const uint8_t[]){ 0x08 }, 1, text, sizeof(text)), -ENOENT);
+    CHECK_EQ(command_decode((const uint8_t[]){ 0xff, 0x00 }, 2, text, sizeof(text)), -ENOENT);
+}
+
+static void test_truncation(void)
+{
+    const uint8_t interval[] = { COMMAND_OP_INTERVAL, 0xff, 0xff, 0xff, 0xff };
+    const size_t needed = sizeof("interval 4294967295");
+    char text[TEXT_SIZE];
+
+    // Rejected rather than cut short, down to no room at all
+    for (size_t size = 0; size < needed; size++) {
+        memset(text, 'x', sizeof(text));
+        CHECK_EQ(command_decode(interval, sizeof(interval), text, size), -EMSGSIZE);
+        CHECK(text[size] == 'x');
+    }
+    CHECK_EQ(command_decode(interval, sizeof(interval), text, needed), 0);
+
+    CHECK_EQ(command_decode((const uint8_t[]){ COMMAND_OP_STATE }, 1, text, 5), -EMSGSIZE);
+    CHECK_EQ(command_decode((const uint8_t[]){ COMMAND_OP_STATE }, 1, text, 6), 0);
+}
+
+// Random downlinks decode to a known command, or are rejected without
+// writing past the buffer
+static void test_random(void)
+{
+    srand(1);
+
+    for (int i = 0; i < 100000; i++) {
+        uint8_t data[8];
+        char text[TEXT_SIZE + 1];
+        size_t length = rand() % sizeof(data);
+        size_t size = rand() % TEXT_SIZE;
+
+        for (size_t j = 0; j < length; j++) {
+            data[j] = (rand() % 4) ? rand() % 10 : rand();
+        }
+        memset(text, 'x', sizeof(text));
+
+        int err = command_decode(data, length, text, size);
+        CHECK(err == 0 || err == -EINVAL || err == -ENOENT || err == -EMSGSIZE);
+        CHECK(text[size] == 'x');
+        if (err == 0) {
+            CHECK(strlen(text) < size);
+        }
+    }
+}
+
+int main(void)
+{
+    test_opcodes();
+    test_malformed();
+    test_truncation();
+    test_random();
+
+    return check_result();
+}
@@ -0,0 +1,51 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Wall clock and, where the host has a cycle counter, cycles for the host
+// benchmarks. Host figures only compare implementations with each other,
+// they say nothing about the time taken on the nRF52840.
+struct bench {
+    struct timespec start;
+    uint64_t cycles;
+};
+
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static inline void bench_start(struct bench *bench)
+{
+    clock_gettime(CLOCK_MONOTONIC, &bench->start);
+    bench->cycles = bench_cycles();
+}
+
+// Seconds since bench_start(), and the cycles in *cycles
+static inline double bench_stop(const struct bench *bench, uint64_t *cycles)
+{
+    struct timespec end;
+
+    *cycles = bench_cycles() - bench->cycles;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - bench->start.tv_sec) + (end.tv_nsec - bench->start.tv_nsec) / 1e9;
+}
+
+// Keeps the compiler from optimising away work whose result is unused
+static inline void bench_use(const void *data)
+{
+    __asm__ volatile("" : : "r"(data) : "memory");
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal assertions for the host tests. A failed check is reported and
+// counted, and the test carries on so one run shows every failure.
+static int check_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        long long _actual = (long long)(actual); \
+        long long _expected = (long long)(expected); \
+        if (_actual != _expected) { \
+            fprintf(stderr, "%s:%d: check failed: %s is %lld, expected %lld\n", \
+                    __FILE__, __LINE__, #actual, _actual, _expected); \
+            check_failures++; \
+        } \
+    } while (0)
+
+// Exit status for main()
+static inline int check_result(void)
+{
+    if (check_failures) {
+        fprintf(stderr, "%d checks failed\n", check_failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Whole file in a NUL terminated buffer, or NULL
+static inline char *check_read_file(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    char *data = NULL;
+
+    if (file && fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+
+        rewind(file);
+        data = size >= 0 ? malloc(size + 1) : NULL;
+        if (data && fread(data, 1, size, file) == (size_t)size) {
+            data[size] = '\0';
+            *length = size;
+        } else {
+            free(data);
+            data = NULL;
+        }
+    }
+    if (file) {
+        fclose(file);
+    }
+    if (!data) {
+        fprintf(stderr, "Cannot read %s\n", path);
+    }
+    return data;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# Run the delta records printed by "test_delta vectors" through the backend
+# decoder in scripts/decode_mqttsn.py and check every decoded sample
+# against the fields the firmware encoded.
+#
+# Usage:
+#   check_decode_delta.py <test_delta> <scripts directory>
+#
+
+import subprocess
+import sys
+
+sys.path.insert(0, sys.argv[2])
+import decode_mqttsn  # noqa: E402
+
+ROLES = decode_mqttsn.ROLES
+
+
+def main():
+    output = subprocess.run([sys.argv[1], "vectors"], check=True, capture_output=True, text=True).stdout
+    failures = 0
+    count = 0
+
+    for line in output.splitlines():
+        record, *values = line.split()
+        status, battery, rloc16, flags, latitude, longitude, elevation, speed, temperature = map(int, values)
+
+        # LoRaWAN version 4 uplinks are bare records, without an age
+        message = decode_mqttsn.decode_delta(bytes.fromhex(record), "ot/vectors", ages=False)
+        sample = message["Samples"][0]
+        expected = {
+            "Role": ROLES[status & 0x0f] if (status & 0x0f) < len(ROLES) else str(status & 0x0f),
+            "Status": "P%d" % (status >> 4),
+            "Battery": battery,
+            "RLOC16": "%04X" % rloc16,
+            "GPSLock": flags & 0x01,
+            "Latitude": latitude,
+            "Longitude": longitude,
+            "Elevation": elevation,
+            "Speed": speed,
+            "Temperature": temperature / 100,
+            "Lost": 0,
+        }
+        for key, value in expected.items():
+            if sample[key] != value:
+                print("record %d %s: %s is %r, expected %r" % (count, record, key, sample[key], value))
+                failures += 1
+        count += 1
+
+    print("%d records decoded, %d differences" % (count, failures))
+    return 1 if failures or count == 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
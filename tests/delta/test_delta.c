@@ -0,0 +1,386 @@
+/*
+ * Delta record tests: the layout documented in delta.h, change-only
+ * records, keyframes, and a receiver rebuilding the state from a lossy
+ * stream of records.
+ *
+ * With "vectors" as its argument the records of a random walk are printed
+ * instead, one per line as the hex record followed by the fields it should
+ * decode to, for check_decode_delta.py to run through decode_mqttsn.py.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include "app.h"
+#include "check.h"
+#include "delta.h"
+
+#define KEYFRAME_INTERVAL CONFIG_DELTA_KEYFRAME_INTERVAL
+
+// Receiver side, as in scripts/decode_mqttsn.py
+struct receiver {
+    struct delta_fields fields;
+    bool known;                 // Fields rebuilt since the last keyframe
+    bool started;
+    uint16_t seq;
+    uint32_t lost;
+};
+
+static const struct delta_report first_report = {
+    .role = 3,                  // Router
+    .triage = 2,
+    .battery = 87,
+    .rloc16 = 0x5c01,
+    .position = {
+        .valid = true,
+        .latitude = 515074000,
+        .longitude = -1278000,
+        .elevation = 35499,     // mm, sent as 35 m
+        .speed = 140,
+    },
+    .temperature = 2150,
+};
+
+static void expected_fields(const struct delta_report *report, struct delta_fields *fields)
+{
+    *fields = (struct delta_fields){
+        .status = (report->role & 0x0f) | (report->triage << 4),
+        .battery = report->battery,
+        .rloc16 = report->rloc16,
+        .flags = report->position.valid,
+        .latitude = report->position.latitude,
+        .longitude = report->position.longitude,
+        .elevation = CLAMP(report->position.elevation / 1000, INT16_MIN, INT16_MAX),
+        .speed = CLAMP(report->position.speed, 0, UINT16_MAX),
+        .temperature = CLAMP(report->temperature, INT16_MIN, INT16_MAX),
+    };
+}
+
+static bool fields_equal(const struct delta_fields *a, const struct delta_fields *b)
+{
+    return a->status == b->status && a->battery == b->battery && a->rloc16 == b->rloc16 &&
+           a->flags == b->flags && a->latitude == b->latitude && a->longitude == b->longitude &&
+           a->elevation == b->elevation && a->speed == b->speed && a->temperature == b->temperature;
+}
+
+// Apply one record, returning its length or 0 if it is malformed
+static size_t receiver_apply(struct receiver *rx, const uint8_t *data, size_t length)
+{
+    struct delta_fields fields = rx->fields;
+    const uint8_t *field = &data[DELTA_HEADER_SIZE];
+
+    if (length < DELTA_HEADER_SIZE || (data[0] & ~DELTA_KEYFRAME) != VERSION) {
+        return 0;
+    }
+
+    uint16_t seq = sys_get_le16(&data[1]);
+    uint8_t mask = data[3];
+    bool keyframe = data[0] & DELTA_KEYFRAME;
+
+    if (keyframe && mask != 0xff) {
+        return 0;
+    }
+    if (mask & DELTA_FIELD_STATUS) {
+        fields.status = *field++;
+    }
+    if (mask & DELTA_FIELD_BATTERY) {
+        fields.battery = *field++;
+    }
+    if (mask & DELTA_FIELD_RLOC16) {
+        fields.rloc16 = sys_get_le16(field);
+        field += 2;
+    }
+    if (mask & DELTA_FIELD_FLAGS) {
+        fields.flags = *field++;
+    }
+    if (mask & DELTA_FIELD_POSITION) {
+        fields.latitude = sys_get_le32(field);
+        fields.longitude = sys_get_le32(field + 4);
+        field += 8;
+    }
+    if (mask & DELTA_FIELD_ELEVATION) {
+        fields.elevation = sys_get_le16(field);
+        field += 2;
+    }
+    if (mask & DELTA_FIELD_SPEED) {
+        fields.speed = sys_get_le16(field);
+        field += 2;
+    }
+    if (mask & DELTA_FIELD_TEMPERATURE) {
+        fields.temperature = sys_get_le16(field);
+        field += 2;
+    }
+    if ((size_t)(field - data) > length) {
+        return 0;
+    }
+
+    // Fields changed in lost records are unknown until the next keyframe
+    if (rx->started && seq != (uint16_t)(rx->seq + 1)) {
+        rx->lost += (uint16_t)(seq - rx->seq - 1);
+        rx->known = false;
+    }
+    rx->started = true;
+    rx->seq = seq;
+    rx->fields = fields;
+    rx->known = keyframe || rx->known;
+
+    return field - data;
+}
+
+static void random_step(struct delta_report *report)
+{
+    // Mostly standing still, as the adaptive filter would leave it
+    switch (rand() % 8) {
+        case 0:
+            report->position.latitude += rand() % 2001 - 1000;
+            report->position.longitude += rand() % 2001 - 1000;
+            report->position.elevation += rand() % 2001 - 1000;
+            report->position.speed = rand() % 500;
+            break;
+        case 1:
+            report->temperature += rand() % 21 - 10;
+            break;
+        case 2:
+            report->battery = rand() % 101;
+            break;
+        case 3:
+            report->role = rand() % 5;
+            report->rloc16 = rand();
+            break;
+        case 4:
+            report->triage = rand() % 4;
+            break;
+        case 5:
+            report->position.valid = !report->position.valid;
+            break;
+        default:
+            break;
+    }
+}
+
+static void test_keyframe_layout(void)
+{
+    struct delta_state state = { 0 };
+    uint8_t data[DELTA_MAX_SIZE];
+    const uint8_t expected[] = {
+        VERSION | DELTA_KEYFRAME, 0x34, 0x12, 0xff,
+        0x23,                                   // Router, P2
+        87,
+        0x01, 0x5c,
+        0x01,
+        0xd0, 0x67, 0xb3, 0x1e,                 // 515074000
+        0xd0, 0x7f, 0xec, 0xff,                 // -1278000
+        0x23, 0x00,                             // 35 m
+        0x8c, 0x00,                             // 140 cm/s
+        0x66, 0x08,                             // 21.50 C
+    };
+
+    CHECK_EQ(delta_encode(&state, &first_report, 0x1234, data, sizeof(data)), sizeof(expected));
+    CHECK(memcmp(data, expected, sizeof(expected)) == 0);
+    CHECK_EQ(sizeof(expected), DELTA_MAX_SIZE);
+}
+
+static void test_changes_only(void)
+{
+    static const struct {
+        uint8_t mask;
+        size_t size;
+    } fields[] = {
+        { DELTA_FIELD_STATUS, 1 },
+        { DELTA_FIELD_BATTERY, 1 },
+        { DELTA_FIELD_RLOC16, 2 },
+        { DELTA_FIELD_FLAGS, 1 },
+        { DELTA_FIELD_POSITION, 8 },
+        { DELTA_FIELD_ELEVATION, 2 },
+        { DELTA_FIELD_SPEED, 2 },
+        { DELTA_FIELD_TEMPERATURE, 2 },
+    };
+    uint8_t data[DELTA_MAX_SIZE];
+
+    for (size_t i = 0; i < ARRAY_SIZE(fields); i++) {
+        struct delta_state state = { 0 };
+        struct delta_report report = first_report;
+
+        delta_encode(&state, &report, 0, data, sizeof(data));
+
+        // Nothing changed, a bare header
+        CHECK_EQ(delta_encode(&state, &report, 1, data, sizeof(data)), DELTA_HEADER_SIZE);
+        CHECK_EQ(data[0], VERSION);
+        CHECK_EQ(data[3], 0);
+
+        switch (fields[i].mask) {
+            case DELTA_FIELD_STATUS: report.triage = 3; break;
+            case DELTA_FIELD_BATTERY: report.battery--; break;
+            case DELTA_FIELD_RLOC16: report.rloc16 = 0x5c02; break;
+            case DELTA_FIELD_FLAGS: report.position.valid = false; break;
+            case DELTA_FIELD_POSITION: report.position.longitude++; break;
+            case DELTA_FIELD_ELEVATION: report.position.elevation += 1000; break;
+            case DELTA_FIELD_SPEED: report.position.speed++; break;
+            case DELTA_FIELD_TEMPERATURE: report.temperature--; break;
+        }
+        CHECK_EQ(delta_encode(&state, &report, 2, data, sizeof(data)), DELTA_HEADER_SIZE + fields[i].size);
+        CHECK_EQ(data[3], fields[i].mask);
+    }
+
+    // Changes below the wire resolution are not sent
+    struct delta_state state = { 0 };
+    struct delta_report report = first_report;
+
+    delta_encode(&state, &report, 0, data, sizeof(data));
+    report.position.elevation += 400;
+    CHECK_EQ(delta_encode(&state, &report, 1, data, sizeof(data)), DELTA_HEADER_SIZE);
+}
+
+static void test_keyframes(void)
+{
+    struct delta_state state = { 0 };
+    uint8_t data[DELTA_MAX_SIZE];
+
+    for (int i = 0; i < 4 * KEYFRAME_INTERVAL; i++) {
+        CHECK(delta_encode(&state, &first_report, i, data, sizeof(data)) > 0);
+        CHECK_EQ(!!(data[0] & DELTA_KEYFRAME), i % KEYFRAME_INTERVAL == 0);
+    }
+
+    // A reset makes the next record a keyframe, and the count starts again
+    delta_reset(&state);
+    delta_encode(&state, &first_report, 0, data, sizeof(data));
+    CHECK(data[0] & DELTA_KEYFRAME);
+    delta_encode(&state, &first_report, 1, data, sizeof(data));
+    CHECK(!(data[0] & DELTA_KEYFRAME));
+}
+
+static void test_too_small(void)
+{
+    struct delta_state state = { 0 };
+    struct delta_state before;
+    uint8_t data[DELTA_MAX_SIZE + 1];
+
+    delta_encode(&state, &first_report, 0, data, sizeof(data));
+    before = state;
+
+    // Rejected without touching the state, even when the record would fit
+    memset(data, 0xaa, sizeof(data));
+    CHECK_EQ(delta_encode(&state, &first_report, 1, data, DELTA_MAX_SIZE - 1), 0);
+    CHECK(memcmp(&state, &before, sizeof(state)) == 0);
+    CHECK_EQ(data[0], 0xaa);
+}
+
+static void test_clamping(void)
+{
+    struct delta_state state = { 0 };
+    struct delta_report report = first_report;
+    struct receiver rx = { 0 };
+    uint8_t data[DELTA_MAX_SIZE];
+
+    report.position.elevation = INT32_MAX;
+    report.position.speed = -5;
+    report.temperature = INT32_MIN;
+    size_t length = delta_encode(&state, &report, 0, data, sizeof(data));
+
+    CHECK_EQ(receiver_apply(&rx, data, length), length);
+    CHECK_EQ(rx.fields.elevation, INT16_MAX);
+    CHECK_EQ(rx.fields.speed, 0);
+    CHECK_EQ(rx.fields.temperature, INT16_MIN);
+}
+
+// A random walk sent over a lossy link. The receiver never holds a wrong
+// state: after a loss it knows nothing until the next keyframe it gets,
+// and from there every record rebuilds the full state.
+static void test_lossy_stream(void)
+{
+    struct delta_state state = { 0 };
+    struct delta_report report = first_report;
+    struct receiver rx = { 0 };
+    uint8_t data[DELTA_MAX_SIZE];
+    size_t bytes = 0;
+    int received = 0;
+    int known = 0;
+    int lost = 0;
+    int lost_before = 0;
+    int unknown_run = 0;
+    int longest_unknown = 0;
+
+    srand(17);
+
+    for (int i = 0; i < 100000; i++) {
+        struct delta_fields expected;
+
+        random_step(&report);
+        size_t length = delta_encode(&state, &report, i, data, sizeof(data));
+        CHECK(length >= DELTA_HEADER_SIZE && length <= DELTA_MAX_SIZE);
+        bytes += length;
+
+        if (rand() % 10 == 0) {
+            lost++;
+            unknown_run++;
+            continue;
+        }
+
+        received++;
+        lost_before = lost;
+        CHECK_EQ(receiver_apply(&rx, data, length), length);
+        CHECK(rx.known || !(data[0] & DELTA_KEYFRAME));
+        expected_fields(&report, &expected);
+        if (rx.known) {
+            CHECK(fields_equal(&rx.fields, &expected));
+            known++;
+            unknown_run = 0;
+        } else {
+            unknown_run++;
+        }
+        longest_unknown = MAX(longest_unknown, unknown_run);
+    }
+
+    // Losses after the last record received go unnoticed
+    CHECK_EQ(rx.lost, lost_before);
+
+    printf("%d records, %d lost, %d of %d received known, longest unknown run %d, "
+           "%.1f bytes per record against %d for a keyframe\n",
+           100000, lost, known, received, longest_unknown,
+           (double)bytes / 100000, DELTA_MAX_SIZE);
+}
+
+static void print_vectors(void)
+{
+    struct delta_state state = { 0 };
+    struct delta_report report = first_report;
+    uint8_t data[DELTA_MAX_SIZE];
+
+    srand(25);
+
+    for (int i = 0; i < 2000; i++) {
+        struct delta_fields f;
+
+        random_step(&report);
+        size_t length = delta_encode(&state, &report, i, data, sizeof(data));
+        expected_fields(&report, &f);
+
+        for (size_t j = 0; j < length; j++) {
+            printf("%02x", data[j]);
+        }
+        printf(" %u %u %u %d %d %d %d %u %d\n", f.status, f.battery, f.rloc16, f.flags,
+               f.latitude, f.longitude, f.elevation, f.speed, f.temperature);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && !strcmp(argv[1], "vectors")) {
+        print_vectors();
+        return EXIT_SUCCESS;
+    }
+
+    test_keyframe_layout();
+    test_changes_only();
+    test_keyframes();
+    test_too_small();
+    test_clamping();
+    test_lossy_stream();
+
+    return check_result();
+}
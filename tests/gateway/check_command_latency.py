@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+#
+# Check the command latency measured by scripts/mqttsn_gateway.py with
+# --command-every, against stand-in clients on localhost: one that queues
+# commands and runs them later, as src/command.c does, and one that blinks
+# for "identify" inside its receive path, as the client did before, so
+# nothing else is handled until it is done.
+#
+# Usage:
+#   check_command_latency.py <scripts directory>
+#
+
+import json
+import os
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+BLINK = 1.0
+COMMAND_EVERY = 2.0
+DURATION = 7.0
+
+CONNECT, CONNACK, REGISTER, REGACK, PUBLISH, SUBSCRIBE, SUBACK = 0x04, 0x05, 0x0A, 0x0B, 0x0C, 0x12, 0x13
+
+
+def packet(msg_type, body):
+    return struct.pack(">BB", len(body) + 2, msg_type) + body
+
+
+def expect(sock, msg_type):
+    while True:
+        data = sock.recv(1280)
+        if data[1] == msg_type:
+            return data[2:data[0]]
+
+
+def client(port, blocking):
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    sock.connect(("::1", port))
+    sock.settimeout(2)
+
+    sock.send(packet(CONNECT, struct.pack(">BBH", 0x04, 0x01, 30) + b"ot-test"))
+    expect(sock, CONNACK)
+    sock.send(packet(REGISTER, struct.pack(">HH", 0, 1) + b"ot/test"))
+    topic_id = struct.unpack_from(">H", expect(sock, REGACK))[0]
+    sock.send(packet(SUBSCRIBE, struct.pack(">BH", 0x00, 2) + b"ot/test/cmnd"))
+    expect(sock, SUBACK)
+
+    count = 0
+    blinking_until = 0.0
+    end = time.monotonic() + DURATION
+    sock.settimeout(0.05)
+    while time.monotonic() < end:
+        try:
+            data = sock.recv(1280)
+        except socket.timeout:
+            continue
+        if data[1] != PUBLISH:
+            continue
+        command = data[7:data[0]].decode()
+        if command == "identify":
+            if blocking:
+                time.sleep(BLINK)
+            else:
+                blinking_until = time.monotonic() + BLINK
+        elif command == "state":
+            payload = json.dumps({"Count": count, "Samples": [{"Age": 0}]}).encode()
+            sock.send(packet(PUBLISH, struct.pack(">BHH", 0x00, topic_id, 0) + payload))
+            count += 1
+    sock.close()
+    return blinking_until
+
+
+def run(scripts, blocking):
+    probe = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    probe.bind(("::1", 0))
+    port = probe.getsockname()[1]
+    probe.close()
+
+    gateway = subprocess.Popen([sys.executable, os.path.join(scripts, "mqttsn_gateway.py"), "--port", str(port),
+                                "--multicast", "", "--report", "3600", "--command-every", str(COMMAND_EVERY),
+                                "--command", "identify"], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                               text=True)
+    time.sleep(0.5)
+    try:
+        client(port, blocking)
+    finally:
+        gateway.send_signal(signal.SIGINT)
+        _, errors = gateway.communicate(timeout=10)
+    return json.loads(errors.strip().splitlines()[-1].split(" ", 1)[1])
+
+
+def main():
+    failures = 0
+    for blocking in (False, True):
+        summary = run(sys.argv[1], blocking)
+        name = "blocking" if blocking else "queued"
+        print("%-8s commands %d, latency p50 %s s, max %s s" % (
+            name, summary["Commands"], summary["CommandLatencyP50"], summary["CommandLatencyMax"]))
+
+        if not summary["Commands"] or summary["CommandLatencyMax"] is None:
+            print("%s: no command answered" % name)
+            failures += 1
+        elif blocking and summary["CommandLatencyP50"] < BLINK:
+            print("%s: latency below the blink, the gateway does not see the stall" % name)
+            failures += 1
+        elif not blocking and summary["CommandLatencyMax"] >= BLINK / 2:
+            print("%s: latency of a queued command reached %.2f s" % (name, summary["CommandLatencyMax"]))
+            failures += 1
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
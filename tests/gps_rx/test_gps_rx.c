@@ -0,0 +1,425 @@
+/*
+ * Receive ring tests, and a drop count for each UART receive mode.
+ *
+ * The drop count streams an NMEA log through the ring at 115200 baud on a
+ * simulated clock. In interrupt mode every byte is handed over by its own
+ * RX interrupt; in async mode a DMA buffer is handed over when it fills or
+ * the line has been idle for the RX timeout. The parser thread takes a
+ * fixed time per sentence and is held off by higher priority threads for a
+ * while every so often, and every interrupt it sits through delays it
+ * further. Sentences that find the ring full are dropped.
+ *
+ * Usage: test_gps_rx [nmea log]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "check.h"
+#include "gps_rx.h"
+
+// 10 bits per byte at 115200 baud
+#define BYTE_NS 86806LL
+#define FIX_INTERVAL_NS 100000000LL
+#define REPEATS 50
+
+#define ASYNC_BUF_SIZE 128
+#define ASYNC_TIMEOUT_NS 1000000LL
+
+// Time in the interrupt handler, per interrupt
+#define IRQ_NS 8000LL
+#define ASYNC_NS 20000LL
+
+struct sentence {
+    const char *text;
+    size_t length;
+};
+
+struct log {
+    const char *data;
+    size_t length;
+    struct sentence *sentences;
+    size_t count;
+    size_t *fix_starts;             // Offsets of the RMC starting each fix
+    size_t fixes;
+};
+
+struct parser_model {
+    const char *name;
+    long long parse_ns;             // Per sentence
+    long long stall_every_ns;       // 0 for never
+    long long stall_ns;
+};
+
+struct sim {
+    struct gps_rx rx;
+    const struct log *log;
+    const struct parser_model *parser;
+    bool parsing;
+    long long parse_done;
+    size_t expected;                // Index of the next sentence to come out
+    size_t consumed;
+    size_t skipped;
+    size_t mismatched;
+    size_t interrupts;
+    long long isr_ns;
+};
+
+static struct gps_rx rx;
+
+static void rx_reset(struct gps_rx *ring)
+{
+    memset(ring, 0, sizeof(*ring));
+}
+
+static size_t push(const char *text)
+{
+    return gps_rx_chunk(&rx, text, strlen(text));
+}
+
+static void test_split(void)
+{
+    static const char stream[] = "$GPA*00\r\n\r\n$GPBB*00\n$GPCCC*00\r$GPDDDD*00\r\n";
+    static const char *const expected[] = { "$GPA*00", "$GPBB*00", "$GPCCC*00", "$GPDDDD*00" };
+
+    // Every chunk size, so lines and line endings are split at every offset
+    for (size_t chunk = 1; chunk < sizeof(stream); chunk++) {
+        size_t completed = 0;
+
+        rx_reset(&rx);
+        for (size_t i = 0; i < sizeof(stream) - 1; i += chunk) {
+            completed += gps_rx_chunk(&rx, &stream[i], MIN(chunk, sizeof(stream) - 1 - i));
+        }
+
+        CHECK_EQ(completed, ARRAY_SIZE(expected));
+        for (size_t i = 0; i < ARRAY_SIZE(expected); i++) {
+            const char *line = gps_rx_peek(&rx);
+
+            CHECK(line != NULL && strcmp(line, expected[i]) == 0);
+            gps_rx_release(&rx);
+        }
+        CHECK(gps_rx_peek(&rx) == NULL);
+        CHECK_EQ(gps_rx_dropped(&rx), 0);
+    }
+}
+
+static void test_overlong(void)
+{
+    char line[GPS_RX_SLOT_SIZE + 8];
+
+    rx_reset(&rx);
+
+    // One character too many for a slot, then a sentence that fits exactly
+    memset(line, 'A', GPS_RX_SLOT_SIZE);
+    line[GPS_RX_SLOT_SIZE] = '\0';
+    CHECK_EQ(push(line), 0);
+    CHECK_EQ(push("\r\n"), 0);
+    CHECK_EQ(gps_rx_dropped(&rx), 1);
+
+    line[GPS_RX_SLOT_SIZE - 1] = '\0';
+    CHECK_EQ(push(line), 0);
+    CHECK_EQ(push("\r\n"), 1);
+    CHECK(gps_rx_peek(&rx) != NULL && strlen(gps_rx_peek(&rx)) == GPS_RX_SLOT_SIZE - 1);
+}
+
+static void test_full(void)
+{
+    char line[16];
+
+    rx_reset(&rx);
+    for (int i = 0; i <= GPS_RX_SLOTS; i++) {
+        snprintf(line, sizeof(line), "$GP%03d\r\n", i);
+        push(line);
+    }
+    CHECK_EQ(gps_rx_dropped(&rx), 1);
+
+    // The sentences already queued are intact, the last one was dropped
+    for (int i = 0; i < GPS_RX_SLOTS; i++) {
+        snprintf(line, sizeof(line), "$GP%03d", i);
+        CHECK(gps_rx_peek(&rx) != NULL && strcmp(gps_rx_peek(&rx), line) == 0);
+        gps_rx_release(&rx);
+    }
+    CHECK(gps_rx_peek(&rx) == NULL);
+
+    // Room again
+    CHECK_EQ(push("$GPNEXT\r\n"), 1);
+}
+
+static void test_wrap(void)
+{
+    char line[16];
+
+    // Start just short of the signed overflow of the free running indices
+    rx_reset(&rx);
+    atomic_set(&rx.head, __LONG_MAX__ - 2);
+    atomic_set(&rx.tail, __LONG_MAX__ - 2);
+
+    for (int i = 0; i < 4 * GPS_RX_SLOTS; i++) {
+        snprintf(line, sizeof(line), "$GP%03d\r\n", i);
+        push(line);
+        if (i < 2) {
+            continue;
+        }
+        // Keep the ring part full across the wrap
+        snprintf(line, sizeof(line), "$GP%03d", i - 2);
+        CHECK(gps_rx_peek(&rx) != NULL && strcmp(gps_rx_peek(&rx), line) == 0);
+        gps_rx_release(&rx);
+    }
+    CHECK_EQ(gps_rx_dropped(&rx), 0);
+}
+
+// Drop count
+
+static bool load_log(struct log *log, const char *path)
+{
+    size_t length;
+    char *data = check_read_file(path, &length);
+
+    if (!data) {
+        return false;
+    }
+
+    log->data = data;
+    log->length = length;
+    log->sentences = calloc(length, sizeof(*log->sentences));
+    log->fix_starts = calloc(length + 1, sizeof(*log->fix_starts));
+
+    for (size_t i = 0; i < length; ) {
+        size_t end = i;
+
+        while (end < length && data[end] != '\r' && data[end] != '\n') {
+            end++;
+        }
+        if (end > i) {
+            if (end - i > 6 && memcmp(&data[i + 3], "RMC", 3) == 0) {
+                log->fix_starts[log->fixes++] = i;
+            }
+            log->sentences[log->count++] = (struct sentence){ &data[i], end - i };
+        }
+        i = end + 1;
+    }
+    log->fix_starts[log->fixes] = length;
+
+    return log->count > 0 && log->fixes > 0;
+}
+
+// When the parser finishes work started at start, around the stalls
+static long long parser_finish(const struct parser_model *parser, long long start, long long work)
+{
+    long long t = start;
+
+    if (!parser->stall_every_ns) {
+        return t + work;
+    }
+
+    for (;;) {
+        long long window = t / parser->stall_every_ns * parser->stall_every_ns;
+
+        if (t < window + parser->stall_ns) {
+            t = window + parser->stall_ns;
+        }
+
+        long long next = window + parser->stall_every_ns;
+        if (t + work <= next) {
+            return t + work;
+        }
+        work -= next - t;
+        t = next;
+    }
+}
+
+static void sim_check_line(struct sim *sim, const char *line)
+{
+    const struct log *log = sim->log;
+    size_t length = strlen(line);
+
+    // Lines only ever go missing, never change or come out of order
+    for (size_t i = sim->expected; i < log->count * REPEATS; i++) {
+        const struct sentence *sentence = &log->sentences[i % log->count];
+
+        if (sentence->length == length && memcmp(sentence->text, line, length) == 0) {
+            sim->skipped += i - sim->expected;
+            sim->expected = i + 1;
+            return;
+        }
+    }
+    sim->mismatched++;
+}
+
+static void sim_advance(struct sim *sim, long long now)
+{
+    while (sim->parsing && sim->parse_done <= now) {
+        sim_check_line(sim, gps_rx_peek(&sim->rx));
+        gps_rx_release(&sim->rx);
+        sim->consumed++;
+
+        sim->parsing = gps_rx_peek(&sim->rx) != NULL;
+        if (sim->parsing) {
+            sim->parse_done = parser_finish(sim->parser, sim->parse_done, sim->parser->parse_ns);
+        }
+    }
+}
+
+static void sim_interrupt(struct sim *sim, long long now, const char *data, size_t len, long long cost)
+{
+    sim_advance(sim, now);
+
+    // The parser thread sits out the interrupt
+    if (sim->parsing) {
+        sim->parse_done += cost;
+    }
+    sim->interrupts++;
+    sim->isr_ns += cost;
+
+    gps_rx_chunk(&sim->rx, data, len);
+
+    if (!sim->parsing && gps_rx_peek(&sim->rx) != NULL) {
+        sim->parsing = true;
+        sim->parse_done = parser_finish(sim->parser, now + cost, sim->parser->parse_ns);
+    }
+}
+
+// Calls back for every byte of the log, repeated, with its arrival time
+typedef void (*byte_fn)(struct sim *sim, long long now, const char *byte, void *context);
+
+static long long stream(struct sim *sim, byte_fn fn, void *context)
+{
+    const struct log *log = sim->log;
+    long long line_free = 0;
+
+    for (size_t repeat = 0; repeat < REPEATS; repeat++) {
+        for (size_t fix = 0; fix < log->fixes; fix++) {
+            long long start = (long long)(repeat * log->fixes + fix) * FIX_INTERVAL_NS;
+            long long t = MAX(start, line_free);
+
+            for (size_t i = log->fix_starts[fix]; i < log->fix_starts[fix + 1]; i++) {
+                t += BYTE_NS;
+                fn(sim, t, &log->data[i], context);
+            }
+            line_free = t;
+        }
+    }
+    return line_free;
+}
+
+static void irq_byte(struct sim *sim, long long now, const char *byte, void *context)
+{
+    sim_interrupt(sim, now, byte, 1, IRQ_NS);
+}
+
+struct dma {
+    const char *start;
+    size_t filled;
+    long long last;
+};
+
+static void dma_flush(struct sim *sim, struct dma *dma, long long now)
+{
+    if (dma->filled) {
+        sim_interrupt(sim, now, dma->start, dma->filled, ASYNC_NS);
+        dma->start += dma->filled;
+        dma->filled = 0;
+    }
+}
+
+static void dma_byte(struct sim *sim, long long now, const char *byte, void *context)
+{
+    struct dma *dma = context;
+
+    // Idle timeout since the last byte, then a full buffer
+    if (dma->filled && now - BYTE_NS - dma->last >= ASYNC_TIMEOUT_NS) {
+        dma_flush(sim, dma, dma->last + ASYNC_TIMEOUT_NS);
+    }
+    if (!dma->filled) {
+        dma->start = byte;
+    }
+    // The log repeats, so a buffer never spans the end of it
+    if (dma->start + dma->filled != byte) {
+        dma_flush(sim, dma, now - BYTE_NS);
+        dma->start = byte;
+    }
+
+    dma->filled++;
+    dma->last = now;
+    if (dma->filled == ASYNC_BUF_SIZE) {
+        dma_flush(sim, dma, now);
+    }
+}
+
+static void run_mode(const struct log *log, const struct parser_model *parser, const char *mode, bool async,
+                     size_t *dropped)
+{
+    static struct sim sim;
+    struct dma dma = { 0 };
+
+    memset(&sim, 0, sizeof(sim));
+    sim.log = log;
+    sim.parser = parser;
+
+    long long end = async ? stream(&sim, dma_byte, &dma) : stream(&sim, irq_byte, NULL);
+    if (async) {
+        dma_flush(&sim, &dma, dma.last + ASYNC_TIMEOUT_NS);
+    }
+    sim_advance(&sim, INT64_MAX);
+
+    size_t total = log->count * REPEATS;
+
+    // Sentences missing at the end of the run
+    sim.skipped += total - sim.expected;
+
+    printf("%-10s %-9s %9zu %9zu %8ld %7.2f%%\n", parser->name, mode, total, sim.interrupts,
+           (long)gps_rx_dropped(&sim.rx), 100.0 * sim.isr_ns / end);
+
+    // Everything is either parsed intact or counted as dropped
+    CHECK_EQ(sim.mismatched, 0);
+    CHECK_EQ(sim.consumed + gps_rx_dropped(&sim.rx), total);
+    CHECK_EQ(sim.skipped, gps_rx_dropped(&sim.rx));
+
+    *dropped = gps_rx_dropped(&sim.rx);
+}
+
+static void test_drops(const char *path)
+{
+    static const struct parser_model parsers[] = {
+        { "nominal", 300000, 0, 0 },
+        { "stalled", 300000, 1000000000, 40000000 },
+        { "slow", 6000000, 0, 0 },
+    };
+    struct log log = { 0 };
+
+    if (!load_log(&log, path)) {
+        CHECK(false);
+        return;
+    }
+
+    printf("%zu sentences in %zu fixes, %zu bytes, %d slots, repeated %d times\n",
+           log.count, log.fixes, log.length, GPS_RX_SLOTS, REPEATS);
+    printf("%-10s %-9s %9s %9s %8s %8s\n", "parser", "mode", "sentences", "irqs", "dropped", "isr cpu");
+
+    for (size_t i = 0; i < ARRAY_SIZE(parsers); i++) {
+        size_t irq_dropped, async_dropped;
+
+        run_mode(&log, &parsers[i], "interrupt", false, &irq_dropped);
+        run_mode(&log, &parsers[i], "async", true, &async_dropped);
+
+        // A parser that keeps up loses nothing in either mode
+        if (i == 0) {
+            CHECK_EQ(irq_dropped, 0);
+            CHECK_EQ(async_dropped, 0);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    test_split();
+    test_overlong();
+    test_full();
+    test_wrap();
+    test_drops(argc > 1 ? argv[1] : NMEA_LOG);
+
+    return check_result();
+}
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the Zephyr header of the same name, covering only what
+ * the modules under test use. They make no kernel calls.
+ */
+
+#ifndef ZEPHYR_INCLUDE_KERNEL_H_
+#define ZEPHYR_INCLUDE_KERNEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/toolchain.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#define MSEC_PER_SEC 1000
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * Host stand-in for the Zephyr header of the same name, covering only what
+ * the modules under test use.
+ */
+
+#ifndef ZEPHYR_INCLUDE_SYS_BYTEORDER_H_
+#define ZEPHYR_INCLUDE_SYS_BYTEORDER_H_
+
+#include <stdint.h>
+
+static inline void sys_put_le16(uint16_t val, uint8_t dst[2])
+{
+    dst[0] = val;
+    dst[1] = val >> 8;
+}
+
+static inline void sys_put_le32(uint32_t val, uint8_t dst[4])
+{
+    sys_put_le16(val, dst);
+    sys_put_le16(val >> 16, &dst[2]);
+}
+
+static inline uint16_t sys_get_le16(const uint8_t src[2])
+{
+    return ((uint16_t)src[1] << 8) | src[0];
+}
+
+static inline uint32_t sys_get_le32(const uint8_t src[4])
+{
+    return ((uint32_t)sys_get_le16(&src[2]) << 16) | sys_get_le16(&src[0]);
+}
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for the Zephyr header of the same name, covering only what
+ * the modules under test use.
+ */
+
+#ifndef ZEPHYR_INCLUDE_TOOLCHAIN_H_
+#define ZEPHYR_INCLUDE_TOOLCHAIN_H_
+
+#define BUILD_ASSERT(expr, msg...) _Static_assert(expr, "" msg)
+
+#define ARG_UNUSED(x) (void)(x)
+
+#define _STRINGIFY(x) #x
+#define STRINGIFY(s) _STRINGIFY(s)
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ * Simulates a node that carries its telemetry over LoRaWAN alone while the
+ * network server moves it between data rates, and reports per data rate
+ * what reaches the backend for the time spent on air. The node samples
+ * every CONFIG_TELEMETRY_SAMPLE_INTERVAL_S into a ring of
+ * CONFIG_TELEMETRY_BUFFER_SAMPLES and is polled as lorawan_client.c does:
+ * every 5 s, at least CONFIG_UPLINK_LORAWAN_INTERVAL_S apart, at most
+ * CONFIG_UPLINK_LORAWAN_BUDGET an hour and within the duty cycle.
+ *
+ * Each run is made twice, packing as many records as the data rate allows
+ * with lorawan_pack_newest() and with only the newest record per uplink.
+ *
+ * Usage: sim_datarate [hours] [seed]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "airtime.h"
+#include "check.h"
+#include "lorawan_pack.h"
+
+#define SAMPLE_INTERVAL_MS (10 * 1000LL)
+#define BUFFER_SAMPLES 32
+#define POLL_INTERVAL_MS (5 * 1000LL)
+#define UPLINK_INTERVAL_MS (30 * 1000LL)
+#define BUDGET 20
+#define DUTY_CYCLE 100
+
+#define HOUR_MS (3600 * 1000LL)
+
+// The network server reconsiders the data rate every 20 minutes
+#define DATARATE_PERIOD_MS (20 * 60 * 1000LL)
+
+#define DATARATES 8
+
+// EU868 FRMPayload limits per data rate, without MAC commands
+static const uint8_t max_payload[DATARATES] = { 51, 51, 51, 115, 242, 242, 242, 242 };
+
+struct stats {
+    uint32_t uplinks;
+    uint32_t repeats;           // Uplinks with no new sample, the latest sent again
+    uint64_t airtime_us;
+    uint64_t bytes;
+    uint64_t delivered;         // Samples carried by an uplink
+    uint64_t age_ms;            // Summed over the delivered samples
+};
+
+struct node {
+    struct telemetry_sample *history;   // Every sample, indexed by seq
+    uint32_t count;
+    struct telemetry_sample current;
+    uint32_t cursor;                    // First sample not yet sent
+    bool sent_any;
+    struct delta_state delta;
+    uint16_t records;                   // LoRaWAN record sequence
+    struct airtime_tracker airtime;
+    int64_t last_sent;
+    int64_t window_start;
+    uint16_t used;
+    struct stats stats[DATARATES];
+};
+
+// Stands still most of the time and now and then moves for a while
+static void sample(struct node *node, int64_t now, bool moving)
+{
+    struct telemetry_sample *current = &node->current;
+
+    if (moving) {
+        current->position.latitude += rand() % 2001 - 1000;
+        current->position.longitude += rand() % 2001 - 1000;
+        current->position.elevation += rand() % 201 - 100;
+        current->position.speed = 100 + rand() % 400;
+    } else {
+        current->position.speed = 0;
+    }
+    if (rand() % 30 == 0) {
+        current->temperature += rand() % 11 - 5;
+    }
+    if (rand() % 500 == 0 && current->battery > 0) {
+        current->battery--;
+    }
+    current->seq = node->count;
+    current->timestamp = now;
+    node->history[node->count++] = *current;
+}
+
+static void poll(struct node *node, int64_t now, uint8_t dr, bool pack)
+{
+    static uint8_t data[LORAWAN_PACK_BUFFER_SIZE];
+    struct telemetry_sample run[BUFFER_SAMPLES];
+    struct delta_state delta;
+    size_t n, packed;
+
+    if (!airtime_ready(&node->airtime, now)) {
+        return;
+    }
+    if (now - node->window_start >= HOUR_MS) {
+        node->window_start = now;
+        node->used = 0;
+    }
+    if (node->used >= BUDGET || (node->sent_any && now - node->last_sent < UPLINK_INTERVAL_MS)) {
+        return;
+    }
+    if (node->count == 0) {
+        return;
+    }
+
+    // The samples not yet sent that are still in the ring, or the latest
+    uint32_t oldest = node->count > BUFFER_SAMPLES ? node->count - BUFFER_SAMPLES : 0;
+    uint32_t first = MAX(node->cursor, oldest);
+    bool fresh = first < node->count;
+
+    n = fresh ? node->count - first : 1;
+    memcpy(run, &node->history[node->count - n], n * sizeof(run[0]));
+
+    size_t count = pack ? n : 1;
+    size_t length = lorawan_pack_newest(&run[n - count], count, now, node->records, &node->delta, data,
+                                        max_payload[dr], &packed, &delta);
+    if (length == 0) {
+        fprintf(stderr, "%lld ms: nothing fits at DR%u\n", (long long)now, dr);
+        check_failures++;
+        return;
+    }
+    CHECK(length <= max_payload[dr]);
+
+    uint32_t toa = airtime_us(dr, length);
+    struct stats *stats = &node->stats[dr];
+
+    airtime_sent(&node->airtime, now, toa);
+    node->delta = delta;
+    node->records += packed;
+    node->last_sent = now;
+    node->sent_any = true;
+    node->used++;
+
+    stats->uplinks++;
+    stats->airtime_us += toa;
+    stats->bytes += length;
+    if (fresh) {
+        uint32_t newest = node->count - 1;
+
+        stats->delivered += packed;
+        for (uint32_t seq = newest + 1 - packed; seq <= newest; seq++) {
+            stats->age_ms += now - node->history[seq].timestamp;
+        }
+        node->cursor = node->count;
+    } else {
+        stats->repeats++;
+    }
+}
+
+// The data rate the network server picks for each period, as a node
+// drifts in and out of range of its gateways
+static uint8_t datarate(int64_t now)
+{
+    static const uint8_t schedule[] = { 5, 5, 4, 3, 3, 2, 1, 0, 0, 1, 2, 3, 4, 5, 5, 6, 6, 5 };
+
+    return schedule[(now / DATARATE_PERIOD_MS) % ARRAY_SIZE(schedule)];
+}
+
+static void run(struct node *node, int64_t duration, unsigned int seed, bool pack)
+{
+    struct telemetry_sample *history = node->history;
+
+    memset(node, 0, sizeof(*node));
+    node->history = history;
+    node->airtime.duty_cycle = DUTY_CYCLE;
+    node->current = (struct telemetry_sample){
+        .position = { .valid = true, .latitude = 515074000, .longitude = -1278000, .elevation = 35000 },
+        .temperature = 2150,
+        .rloc16 = 0xfffe,
+        .role = 0,
+        .battery = 100,
+    };
+
+    srand(seed);
+    bool moving = false;
+    for (int64_t now = 0; now < duration; now += POLL_INTERVAL_MS) {
+        if (now % SAMPLE_INTERVAL_MS == 0) {
+            // Trips of a few minutes, a few times an hour
+            if (now % (60 * 1000) == 0) {
+                moving = moving ? rand() % 4 != 0 : rand() % 10 == 0;
+            }
+            sample(node, now, moving);
+        }
+        poll(node, now, datarate(now), pack);
+    }
+}
+
+static void report(const struct node *node, const char *name, uint64_t samples)
+{
+    struct stats total = { 0 };
+
+    printf("%-7s %4s %8s %8s %10s %10s %12s %12s %10s\n", name, "DR", "uplinks", "repeats", "airtime s",
+           "samples", "samples/s", "bytes/sample", "mean age s");
+    for (int dr = 0; dr < DATARATES; dr++) {
+        const struct stats *stats = &node->stats[dr];
+
+        total.uplinks += stats->uplinks;
+        total.repeats += stats->repeats;
+        total.airtime_us += stats->airtime_us;
+        total.bytes += stats->bytes;
+        total.delivered += stats->delivered;
+        total.age_ms += stats->age_ms;
+        if (stats->uplinks == 0) {
+            continue;
+        }
+        printf("%-7s %4d %8u %8u %10.1f %10llu %12.1f %12.1f %10.1f\n", "", dr, stats->uplinks,
+               stats->repeats, stats->airtime_us / 1e6, (unsigned long long)stats->delivered,
+               stats->delivered / (stats->airtime_us / 1e6), (double)stats->bytes / MAX(stats->delivered, 1),
+               stats->age_ms / 1e3 / MAX(stats->delivered, 1));
+    }
+    printf("%-7s %4s %8u %8u %10.1f %10llu %12.1f %12.1f %10.1f\n", "", "all", total.uplinks, total.repeats,
+           total.airtime_us / 1e6, (unsigned long long)total.delivered,
+           total.delivered / (total.airtime_us / 1e6), (double)total.bytes / MAX(total.delivered, 1),
+           total.age_ms / 1e3 / MAX(total.delivered, 1));
+    printf("%-7s %llu of %llu samples delivered, %.1f%%\n\n", "", (unsigned long long)total.delivered,
+           (unsigned long long)samples, 100.0 * total.delivered / samples);
+}
+
+int main(int argc, char **argv)
+{
+    int64_t duration = (argc > 1 ? atol(argv[1]) : 24) * HOUR_MS;
+    unsigned int seed = argc > 2 ? atoi(argv[2]) : 23;
+    struct node packed, newest;
+
+    packed.history = calloc(duration / SAMPLE_INTERVAL_MS + 1, sizeof(struct telemetry_sample));
+    newest.history = calloc(duration / SAMPLE_INTERVAL_MS + 1, sizeof(struct telemetry_sample));
+    if (!packed.history || !newest.history) {
+        return EXIT_FAILURE;
+    }
+
+    run(&packed, duration, seed, true);
+    run(&newest, duration, seed, false);
+
+    report(&packed, "packed", packed.count);
+    report(&newest, "newest", newest.count);
+
+    // Packing delivers more samples for each second on air at every data
+    // rate both sent at, and more samples overall
+    uint64_t delivered[2] = { 0 };
+    for (int dr = 0; dr < DATARATES; dr++) {
+        const struct stats *a = &packed.stats[dr];
+        const struct stats *b = &newest.stats[dr];
+
+        if (a->delivered && b->delivered) {
+            CHECK(a->delivered * b->airtime_us > b->delivered * a->airtime_us);
+        }
+        delivered[0] += a->delivered;
+        delivered[1] += b->delivered;
+    }
+    CHECK(delivered[0] > delivered[1]);
+
+    free(packed.history);
+    free(newest.history);
+    return check_result();
+}
@@ -0,0 +1,157 @@
+/*
+ * LoRaWAN uplink packing tests: the newest sample is always packed, the
+ * run is as long as fits and no longer, records are numbered on from the
+ * LoRaWAN sequence and the reference delta state is left alone.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "check.h"
+#include "lorawan_pack.h"
+
+#define SAMPLES 64
+#define NOW (3600 * 1000LL)
+
+static struct telemetry_sample samples[SAMPLES];
+
+static void walk(unsigned int seed)
+{
+    struct telemetry_sample sample = {
+        .position = { .valid = true, .latitude = 515074000, .longitude = -1278000, .elevation = 35000 },
+        .temperature = 2150,
+        .rloc16 = 0x5c01,
+        .role = 3,
+        .battery = 90,
+    };
+
+    srand(seed);
+    for (int i = 0; i < SAMPLES; i++) {
+        if (rand() % 2 == 0) {
+            sample.position.latitude += rand() % 20001 - 10000;
+            sample.position.longitude += rand() % 20001 - 10000;
+            sample.position.speed = rand() % 300;
+        }
+        if (rand() % 4 == 0) {
+            sample.temperature += rand() % 21 - 10;
+        }
+        sample.seq = 1000 + i;
+        sample.timestamp = NOW - (SAMPLES - i) * 10000LL;
+        samples[i] = sample;
+    }
+}
+
+// The same run encoded directly, for comparison
+static size_t encode(struct telemetry_sample *run, size_t count, const struct delta_state *reference,
+                     uint8_t *data, struct delta_state *delta)
+{
+    const struct telemetry_encode_context context = {
+        .now = NOW,
+        .delta = delta,
+        .ages = true,
+    };
+
+    *delta = *reference;
+    return telemetry_encoder_delta.encode(&context, run, count, data, LORAWAN_PACK_BUFFER_SIZE);
+}
+
+static void test_fit(void)
+{
+    static uint8_t data[LORAWAN_PACK_BUFFER_SIZE];
+    static uint8_t expected[LORAWAN_PACK_BUFFER_SIZE];
+    struct delta_state reference = { 0 };
+    struct delta_state copy, delta, expected_delta;
+    struct telemetry_sample run[SAMPLES];
+    int runs = 0;
+
+    for (unsigned int seed = 0; seed < 200; seed++) {
+        walk(seed);
+
+        // The reference state part way through a keyframe interval
+        if (seed % 3) {
+            struct telemetry_sample warmup[4];
+
+            memcpy(warmup, samples, sizeof(warmup));
+            encode(warmup, seed % 4 + 1, &(struct delta_state){ 0 }, data, &reference);
+        }
+        copy = reference;
+
+        for (size_t size = 0; size <= LORAWAN_PACK_MAX_PAYLOAD; size += 1 + seed % 7) {
+            for (size_t n = 1; n <= SAMPLES; n += 21) {
+                size_t packed;
+                uint16_t seq = seed * 77;
+                size_t length = lorawan_pack_newest(samples, n, NOW, seq, &reference, data, size,
+                                                    &packed, &delta);
+
+                CHECK(!memcmp(&reference, &copy, sizeof(reference)));
+                CHECK(length <= size);
+                CHECK(packed <= n);
+                if (length == 0) {
+                    // Not even the newest record fits
+                    CHECK_EQ(packed, 0);
+                    memcpy(run, &samples[n - 1], sizeof(run[0]));
+                    run[0].seq = seq;
+                    CHECK(encode(run, 1, &reference, expected, &expected_delta) > size);
+                    continue;
+                }
+                runs++;
+
+                // The newest samples, renumbered
+                CHECK(packed > 0);
+                for (size_t i = 0; i < packed; i++) {
+                    CHECK_EQ(samples[n - packed + i].seq, (uint16_t)(seq + i));
+                }
+
+                // The same bytes and state as encoding the run directly
+                memcpy(run, &samples[n - packed], packed * sizeof(run[0]));
+                CHECK_EQ(encode(run, packed, &reference, expected, &expected_delta), length);
+                CHECK(!memcmp(data, expected, length));
+                CHECK(!memcmp(&delta, &expected_delta, sizeof(delta)));
+
+                // One more sample would not have fitted
+                if (packed < n) {
+                    memcpy(run, &samples[n - packed - 1], (packed + 1) * sizeof(run[0]));
+                    for (size_t i = 0; i <= packed; i++) {
+                        run[i].seq = seq + i;
+                    }
+                    size_t longer = encode(run, packed + 1, &reference, expected, &expected_delta);
+                    CHECK(longer == 0 || longer > size);
+                }
+            }
+        }
+    }
+    CHECK(runs > 0);
+}
+
+// A stationary node packs far more samples into the largest payload than a
+// moving one, each record after the keyframe being a header and an age
+static void test_stationary(void)
+{
+    static uint8_t data[LORAWAN_PACK_BUFFER_SIZE];
+    struct delta_state reference = { 0 };
+    struct delta_state delta;
+    size_t packed;
+
+    walk(1);
+    for (int i = 0; i < SAMPLES; i++) {
+        samples[i].position = samples[0].position;
+        samples[i].temperature = samples[0].temperature;
+    }
+
+    size_t length = lorawan_pack_newest(samples, SAMPLES, NOW, 0, &reference, data,
+                                        LORAWAN_PACK_MAX_PAYLOAD, &packed, &delta);
+    CHECK(length > 0 && length <= LORAWAN_PACK_MAX_PAYLOAD);
+    CHECK(packed >= 30);
+}
+
+int main(void)
+{
+    test_fit();
+    test_stationary();
+
+    return check_result();
+}
@@ -0,0 +1,116 @@
+/*
+ * Per sentence cost of the parser thread, before and after parsing in
+ * place.
+ *
+ * Before: each sentence is copied out of the ring slot into a stack buffer
+ * with strncpy and formatted for the "Rx: >%s<" log line, then parsed.
+ * After: the sentence is parsed in the slot and nothing is logged. Both
+ * identify the sentence and parse it with the same minmea_parse_* calls,
+ * so the difference is the copy and the log formatting. The log line is
+ * formatted with snprintf, as the log subsystem would when it renders it,
+ * and not sent anywhere, so the "before" figure is a lower bound.
+ *
+ * Usage: bench_gpsparser [passes over the log] [nmea log]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "check.h"
+#include "minmea.h"
+#include "nmea_log.h"
+
+union frame {
+    struct minmea_sentence_rmc rmc;
+    struct minmea_sentence_gga gga;
+    struct minmea_sentence_gsa gsa;
+    struct minmea_sentence_gll gll;
+    struct minmea_sentence_gst gst;
+    struct minmea_sentence_gsv gsv;
+    struct minmea_sentence_vtg vtg;
+    struct minmea_sentence_zda zda;
+};
+
+static char log_line[256];
+
+// The dispatch switch of gps_dispatch(), without the consumers
+static bool parse(const char *line, union frame *frame)
+{
+    switch (minmea_sentence_id(line, false)) {
+        case MINMEA_SENTENCE_RMC: return minmea_parse_rmc(&frame->rmc, line);
+        case MINMEA_SENTENCE_GGA: return minmea_parse_gga(&frame->gga, line);
+        case MINMEA_SENTENCE_GSA: return minmea_parse_gsa(&frame->gsa, line);
+        case MINMEA_SENTENCE_GLL: return minmea_parse_gll(&frame->gll, line);
+        case MINMEA_SENTENCE_GST: return minmea_parse_gst(&frame->gst, line);
+        case MINMEA_SENTENCE_GSV: return minmea_parse_gsv(&frame->gsv, line);
+        case MINMEA_SENTENCE_VTG: return minmea_parse_vtg(&frame->vtg, line);
+        case MINMEA_SENTENCE_ZDA: return minmea_parse_zda(&frame->zda, line);
+        default: return false;
+    }
+}
+
+static bool copy_log_parse(const char *slot, union frame *frame)
+{
+    char line[MINMEA_MAX_LENGTH + 1];
+
+    strncpy(line, slot, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    snprintf(log_line, sizeof(log_line), "Rx: >%s<", line);
+    bench_use(log_line);
+
+    return parse(line, frame);
+}
+
+static bool in_place(const char *slot, union frame *frame)
+{
+    return parse(slot, frame);
+}
+
+static size_t run(const char *name, const struct nmea_log *log, long passes,
+                  bool (*fn)(const char *slot, union frame *frame), double *per_second)
+{
+    struct bench bench;
+    union frame frame;
+    uint64_t cycles;
+    size_t parsed = 0;
+
+    bench_start(&bench);
+    for (long pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < log->count; i++) {
+            parsed += fn(log->lines[i], &frame);
+            bench_use(&frame);
+        }
+    }
+    double seconds = bench_stop(&bench, &cycles);
+
+    size_t sentences = log->count * passes;
+    *per_second = sentences / seconds;
+    printf("%-16s %10zu %14.0f %12.1f %12.1f\n", name, sentences, *per_second,
+           seconds * 1e9 / sentences, (double)cycles / sentences);
+
+    return parsed;
+}
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 2000;
+    struct nmea_log log;
+    double before, after;
+
+    if (!nmea_log_load(&log, argc > 2 ? argv[2] : NMEA_LOG)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%-16s %10s %14s %12s %12s\n", "", "sentences", "sentences/s", "ns/sentence", "cycles/sent.");
+    size_t copied = run("copy, log, parse", &log, passes, copy_log_parse, &before);
+    size_t placed = run("in place", &log, passes, in_place, &after);
+    printf("speedup %.2fx\n", after / before);
+
+    // Same sentences parsed either way, and the log parses cleanly
+    CHECK_EQ(copied, placed);
+    CHECK_EQ(placed, log.count * passes);
+
+    return check_result();
+}
@@ -0,0 +1,115 @@
+/*
+ * Parse time per sentence type, scanf-driven parsers (minmea_reference.c)
+ * against the single-pass field table in src/minmea.c, over the recorded
+ * log.
+ *
+ * Usage: bench_minmea [passes over the log] [nmea log]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "bench.h"
+#include "check.h"
+#include "minmea.h"
+#include "minmea_reference.h"
+#include "nmea_log.h"
+
+union frame {
+    struct minmea_sentence_rmc rmc;
+    struct minmea_sentence_gga gga;
+    struct minmea_sentence_gsa gsa;
+    struct minmea_sentence_gll gll;
+    struct minmea_sentence_gst gst;
+    struct minmea_sentence_gsv gsv;
+    struct minmea_sentence_vtg vtg;
+    struct minmea_sentence_zda zda;
+};
+
+typedef bool (*parse_fn)(union frame *frame, const char *sentence);
+
+#define PARSER(prefix, name) ((parse_fn)prefix##minmea_parse_##name)
+
+static const struct {
+    const char *name;
+    enum minmea_sentence_id id;
+    parse_fn reference;
+    parse_fn table;
+} parsers[] = {
+    { "RMC", MINMEA_SENTENCE_RMC, PARSER(reference_, rmc), PARSER(, rmc) },
+    { "GGA", MINMEA_SENTENCE_GGA, PARSER(reference_, gga), PARSER(, gga) },
+    { "GSA", MINMEA_SENTENCE_GSA, PARSER(reference_, gsa), PARSER(, gsa) },
+    { "GLL", MINMEA_SENTENCE_GLL, PARSER(reference_, gll), PARSER(, gll) },
+    { "GST", MINMEA_SENTENCE_GST, PARSER(reference_, gst), PARSER(, gst) },
+    { "GSV", MINMEA_SENTENCE_GSV, PARSER(reference_, gsv), PARSER(, gsv) },
+    { "VTG", MINMEA_SENTENCE_VTG, PARSER(reference_, vtg), PARSER(, vtg) },
+    { "ZDA", MINMEA_SENTENCE_ZDA, PARSER(reference_, zda), PARSER(, zda) },
+};
+
+// Seconds to parse the sentences passes times over, counting successes
+static double run(const char **lines, size_t count, long passes, parse_fn parse, uint64_t *cycles, size_t *parsed)
+{
+    struct bench bench;
+    union frame frame;
+
+    *parsed = 0;
+    bench_start(&bench);
+    for (long pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            *parsed += parse(&frame, lines[i]);
+            bench_use(&frame);
+        }
+    }
+    return bench_stop(&bench, cycles);
+}
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 2000;
+    struct nmea_log log;
+    const char **lines;
+    double total_reference = 0, total_table = 0;
+
+    if (!nmea_log_load(&log, argc > 2 ? argv[2] : NMEA_LOG)) {
+        return EXIT_FAILURE;
+    }
+    lines = calloc(log.count, sizeof(*lines));
+
+    printf("%-5s %9s %14s %14s %14s %14s %8s\n", "type", "sentences", "scan ns", "table ns",
+           "scan cycles", "table cycles", "speedup");
+
+    for (size_t p = 0; p < ARRAY_SIZE(parsers); p++) {
+        size_t count = 0, parsed_reference, parsed_table;
+        uint64_t cycles_reference, cycles_table;
+
+        for (size_t i = 0; i < log.count; i++) {
+            if (minmea_sentence_id(log.lines[i], false) == parsers[p].id) {
+                lines[count++] = log.lines[i];
+            }
+        }
+        if (!count) {
+            continue;
+        }
+
+        double reference = run(lines, count, passes, parsers[p].reference, &cycles_reference, &parsed_reference);
+        double table = run(lines, count, passes, parsers[p].table, &cycles_table, &parsed_table);
+        double sentences = (double)count * passes;
+
+        printf("%-5s %9zu %14.1f %14.1f %14.1f %14.1f %7.2fx\n", parsers[p].name, count,
+               reference * 1e9 / sentences, table * 1e9 / sentences,
+               cycles_reference / sentences, cycles_table / sentences, reference / table);
+
+        total_reference += reference;
+        total_table += table;
+
+        CHECK_EQ(parsed_reference, count * passes);
+        CHECK_EQ(parsed_table, count * passes);
+    }
+
+    printf("overall %.2fx\n", total_reference / total_table);
+
+    return check_result();
+}
@@ -0,0 +1,20 @@
+#ifndef MINMEA_REFERENCE_H
+#define MINMEA_REFERENCE_H
+
+#include "minmea.h"
+
+// The scanf-driven parsers from before the field table, see
+// minmea_reference.c
+uint8_t reference_minmea_checksum(const char *sentence);
+bool reference_minmea_check(const char *sentence, bool strict);
+enum minmea_sentence_id reference_minmea_sentence_id(const char *sentence, bool strict);
+bool reference_minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence);
+bool reference_minmea_parse_gga(struct minmea_sentence_gga *frame, const char *sentence);
+bool reference_minmea_parse_gsa(struct minmea_sentence_gsa *frame, const char *sentence);
+bool reference_minmea_parse_gll(struct minmea_sentence_gll *frame, const char *sentence);
+bool reference_minmea_parse_gst(struct minmea_sentence_gst *frame, const char *sentence);
+bool reference_minmea_parse_gsv(struct minmea_sentence_gsv *frame, const char *sentence);
+bool reference_minmea_parse_vtg(struct minmea_sentence_vtg *frame, const char *sentence);
+bool reference_minmea_parse_zda(struct minmea_sentence_zda *frame, const char *sentence);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef NMEA_LOG_H
+#define NMEA_LOG_H
+
+#include <string.h>
+
+#include "check.h"
+#include "minmea.h"
+
+// Sentences of an NMEA log, NUL terminated in place without their line
+// endings, as the receive ring hands them to the parser
+struct nmea_log {
+    char *data;
+    char **lines;
+    size_t count;
+};
+
+static inline bool nmea_log_load(struct nmea_log *log, const char *path)
+{
+    size_t length;
+
+    log->data = check_read_file(path, &length);
+    if (!log->data) {
+        return false;
+    }
+
+    log->lines = calloc(length / 2 + 1, sizeof(*log->lines));
+    log->count = 0;
+
+    for (char *line = strtok(log->data, "\r\n"); line; line = strtok(NULL, "\r\n")) {
+        if (strlen(line) <= MINMEA_MAX_LENGTH) {
+            log->lines[log->count++] = line;
+        }
+    }
+
+    return log->count > 0;
+}
+
+#endif
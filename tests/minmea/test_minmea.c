@@ -0,0 +1,247 @@
+/*
+ * Differential fuzz test of the minmea parsers against the scanf-driven
+ * implementation they replaced (minmea_reference.c).
+ *
+ * Sentences from the recorded log and the examples in the parser comments
+ * are mutated at random, mostly at field level so the mutants stay close to
+ * NMEA and reach deep into the parsers, and every mutant goes through
+ * minmea_check, minmea_sentence_id and all eight parsers of both
+ * implementations. They must agree on every return value and, when a parse
+ * succeeds, on every byte of the frame.
+ *
+ * Usage: test_minmea [mutants] [seed] [nmea log]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "check.h"
+#include "minmea.h"
+#include "minmea_reference.h"
+#include "nmea_log.h"
+
+#define MAX_REPORTED 10
+
+static const char *const examples[] = {
+    "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62",
+    "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+    "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+    "$GPGLL,3723.2475,N,12158.3416,W,161229.487,A,A*41",
+    "$GPGLL,3723.2475,N,12158.3416,W,161229.487,A*2C",
+    "$GPGST,024603.00,3.2,6.6,4.7,47.3,5.8,5.6,22.0*58",
+    "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74",
+    "$GPGSV,3,3,11,22,42,067,42,24,14,311,43,27,05,244,00,,,,*4D",
+    "$GPGSV,4,2,11,08,51,203,30,09,45,215,28*75",
+    "$GPGSV,4,4,13,39,31,170,27*40",
+    "$GPGSV,4,4,13*7B",
+    "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48",
+    "$GPVTG,096.5,T,083.5,M,0.0,N,0.0,K,D*22",
+    "$GPVTG,188.36,T,,M,0.820,N,1.519,K,A*3F",
+    "$GPZDA,201530.00,04,07,2002,00,00*60",
+};
+
+// Field values that sit on the edges of the field parsers
+static const char *const fields[] = {
+    "", "0", "-", "+", ".", "-.", "+.5", " 12", "1 2", "-0", "00", "1.", ".1", "1.2.3",
+    "2147483647", "2147483648", "-2147483648", "-2147483649", "99999999999",
+    "214748364.7", "2147483.6479", "0.00000000001", "12345678901.5",
+    "A", "V", "N", "S", "E", "W", "T", "M", "K", "D", "X", "NS",
+    "123519", "123519.", "123519.1", "123519.1234567", "1235", "12a519", "235960.99",
+    "130998", "13099", "1309981", "13a998", "04", "07", "2002", "-13", "14", "60", "-1",
+    "$GPRMC", "$GPGG", "$GP,GA", "GPGGA", "$GNGSV", "$GLGSV", "$GPXXX",
+};
+
+static const char alphabet[] = "0123456789,.-+*$ ANSEWTMKVDXabz\x7f\x80";
+
+static uint64_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+static size_t field_start(const char *s, size_t length, size_t n)
+{
+    for (size_t i = 0; i < length; i++) {
+        if (s[i] == ',' && n-- == 0) {
+            return i + 1;
+        }
+    }
+    return length;
+}
+
+static size_t field_end(const char *s, size_t length, size_t start)
+{
+    while (start < length && s[start] != ',' && s[start] != '*') {
+        start++;
+    }
+    return start;
+}
+
+// Replace s[start, end) with text, keeping the sentence within the limit
+static size_t splice(char *s, size_t length, size_t start, size_t end, const char *text, size_t text_length)
+{
+    if (length - (end - start) + text_length > MINMEA_MAX_LENGTH) {
+        return length;
+    }
+    memmove(&s[start + text_length], &s[end], length - end);
+    memcpy(&s[start], text, text_length);
+    return length - (end - start) + text_length;
+}
+
+static size_t mutate(char *s, size_t length)
+{
+    size_t at = length ? rng() % length : 0;
+    char c = alphabet[rng() % (sizeof(alphabet) - 1)];
+
+    switch (rng() % 8) {
+        case 0:                     // Overwrite a character
+            if (length) {
+                s[at] = c;
+            }
+            return length;
+        case 1:                     // Insert a character
+            return splice(s, length, at, at, &c, 1);
+        case 2:                     // Delete a character
+            return length ? splice(s, length, at, at + 1, "", 0) : 0;
+        case 3:                     // Cut the sentence short
+            return at;
+        default: {                  // Replace, drop or repeat a field
+            size_t start = field_start(s, length, rng() % 22);
+            size_t end = field_end(s, length, start);
+            const char *field = fields[rng() % ARRAY_SIZE(fields)];
+
+            switch (rng() % 4) {
+                case 0:
+                    return end < length ? splice(s, length, start, end + 1, "", 0) : length;
+                case 1: {
+                    char copy[MINMEA_MAX_LENGTH + 2];
+                    size_t copy_length = end - start;
+
+                    memcpy(copy, &s[start], copy_length);
+                    copy[copy_length++] = ',';
+                    return splice(s, length, start, start, copy, copy_length);
+                }
+                default:
+                    return splice(s, length, start, end, field, strlen(field));
+            }
+        }
+    }
+}
+
+// Put a correct checksum on the end, so the mutant also passes minmea_check
+static size_t fix_checksum(char *s, size_t length)
+{
+    char *star = memchr(s, '*', length);
+    size_t end = star ? (size_t)(star - s) : length;
+    char sum[4];
+
+    if (end + 3 > MINMEA_MAX_LENGTH) {
+        return length;
+    }
+    s[end] = '\0';
+    snprintf(sum, sizeof(sum), "*%02X", reference_minmea_checksum(s));
+    memcpy(&s[end], sum, 3);
+    return end + 3;
+}
+
+static size_t differences;
+static size_t parsed[MINMEA_SENTENCE_ZDA + 1];
+
+static void report(const char *what, const char *sentence)
+{
+    if (differences++ < MAX_REPORTED) {
+        fprintf(stderr, "%s differs for \"%s\"\n", what, sentence);
+    }
+}
+
+#define COMPARE(id, name, type)                                                                 \
+    do {                                                                                        \
+        struct type frame, reference_frame;                                                     \
+        memset(&frame, 0xa5, sizeof(frame));                                                    \
+        memset(&reference_frame, 0xa5, sizeof(reference_frame));                                \
+        bool ok = minmea_parse_##name(&frame, sentence);                                        \
+        bool reference_ok = reference_minmea_parse_##name(&reference_frame, sentence);          \
+        if (ok != reference_ok || (ok && memcmp(&frame, &reference_frame, sizeof(frame)))) {    \
+            report("minmea_parse_" #name, sentence);                                            \
+        }                                                                                       \
+        parsed[id] += ok;                                                                       \
+    } while (0)
+
+static void compare(const char *sentence)
+{
+    for (int strict = 0; strict < 2; strict++) {
+        if (minmea_check(sentence, strict) != reference_minmea_check(sentence, strict)) {
+            report("minmea_check", sentence);
+        }
+        if (minmea_sentence_id(sentence, strict) != reference_minmea_sentence_id(sentence, strict)) {
+            report("minmea_sentence_id", sentence);
+        }
+    }
+
+    COMPARE(MINMEA_SENTENCE_RMC, rmc, minmea_sentence_rmc);
+    COMPARE(MINMEA_SENTENCE_GGA, gga, minmea_sentence_gga);
+    COMPARE(MINMEA_SENTENCE_GSA, gsa, minmea_sentence_gsa);
+    COMPARE(MINMEA_SENTENCE_GLL, gll, minmea_sentence_gll);
+    COMPARE(MINMEA_SENTENCE_GST, gst, minmea_sentence_gst);
+    COMPARE(MINMEA_SENTENCE_GSV, gsv, minmea_sentence_gsv);
+    COMPARE(MINMEA_SENTENCE_VTG, vtg, minmea_sentence_vtg);
+    COMPARE(MINMEA_SENTENCE_ZDA, zda, minmea_sentence_zda);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const names[] = { "", "RMC", "GGA", "GSA", "GLL", "GST", "GSV", "VTG", "ZDA" };
+    long mutants = argc > 1 ? atol(argv[1]) : 300000;
+    struct nmea_log log;
+    const char **corpus;
+    size_t count;
+
+    rng_state = argc > 2 ? strtoull(argv[2], NULL, 0) : 0x9e3779b97f4a7c15ULL;
+    if (!rng_state || !nmea_log_load(&log, argc > 3 ? argv[3] : NMEA_LOG)) {
+        return EXIT_FAILURE;
+    }
+
+    count = log.count + ARRAY_SIZE(examples);
+    corpus = calloc(count, sizeof(*corpus));
+    memcpy(corpus, log.lines, log.count * sizeof(*corpus));
+    memcpy(&corpus[log.count], examples, sizeof(examples));
+
+    // Unmutated first, then the mutants
+    for (size_t i = 0; i < count; i++) {
+        compare(corpus[i]);
+    }
+    for (long n = 0; n < mutants; n++) {
+        char sentence[MINMEA_MAX_LENGTH + 1];
+        size_t length;
+
+        strcpy(sentence, corpus[rng() % count]);
+        length = strlen(sentence);
+        for (int m = 1 + rng() % 4; m > 0; m--) {
+            length = mutate(sentence, length);
+        }
+        if (rng() % 2) {
+            length = fix_checksum(sentence, length);
+        }
+        sentence[length] = '\0';
+
+        compare(sentence);
+    }
+
+    printf("%zu sentences and %ld mutants, parsed:", count, mutants);
+    for (int id = MINMEA_SENTENCE_RMC; id <= MINMEA_SENTENCE_ZDA; id++) {
+        printf(" %s %zu", names[id], parsed[id]);
+    }
+    printf("\n");
+
+    CHECK_EQ(differences, 0);
+
+    return check_result();
+}
@@ -0,0 +1,330 @@
+/*
+ * Simulates the MQTT-SN gateway search of a large Thread network after a
+ * leader reboot, and measures the SEARCHGW multicast load it causes.
+ *
+ * Every node detaches within a few seconds of the reboot, re-attaches as a
+ * child over the next minute and some become routers later on. The border
+ * router, and with it the gateway, was on the leader and only answers again
+ * after a while. Each SEARCHGW to the realm-local group is flooded by every
+ * router, so each one costs the mesh a frame per router.
+ *
+ * Two clients are compared:
+ *   - "polling", the client before the state machine: SEARCHGW on every
+ *     role change and every 10 s while not connected
+ *   - "backoff", src/mqttsn.c: the cached gateway tried first, then
+ *     SEARCHGW with backoff_delay_ms(), role changes ignored once attached
+ *
+ * Usage: sim_search [nodes] [gateway back after s] [seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "backoff.h"
+#include "check.h"
+
+// Kconfig defaults and the client configuration in mqttsn.c
+#define SEARCH_BACKOFF_MIN_MS (2 * 1000U)
+#define SEARCH_BACKOFF_MAX_MS (300 * 1000U)
+#define RETRANSMISSION_COUNT 3
+#define RETRANSMISSION_TIMEOUT_MS (10 * 1000LL)
+#define POLL_INTERVAL_MS (10 * 1000LL)
+
+// A CONNECT to a gateway that does not answer fails once every
+// retransmission has timed out
+#define CONNECT_TIMEOUT_MS ((RETRANSMISSION_COUNT + 1) * RETRANSMISSION_TIMEOUT_MS)
+
+#define MAX_ROUTERS 32
+#define ROUND_TRIP_MS 200
+#define LOSS_PERCENT 10
+
+#define STEP_MS 100
+#define DURATION_MS (60 * 60 * 1000LL)
+#define SECONDS (DURATION_MS / 1000)
+
+enum state {
+    DETACHED,
+    WAITING,        // Search or direct connect scheduled
+    CONNECTING,
+    CONNECTED,
+};
+
+struct node {
+    // The network, the same for both clients
+    int64_t detach;
+    int64_t attach;
+    int64_t promote;                // Becomes a router, -1 if it stays a child
+    int64_t poll_phase;
+
+    enum state state;
+    bool attached;
+    bool cached;
+    uint8_t attempts;
+    int64_t next;                   // Scheduled search, or connection outcome
+    bool outcome;
+    int64_t connected;
+    uint32_t misses;                // Searches and connects failed after the gateway was back
+};
+
+struct result {
+    uint32_t searches;
+    uint32_t per_second[SECONDS];
+    uint32_t direct;                // Unicast CONNECTs to the cached gateway
+    int64_t *connected;             // Time to connect after the gateway is back
+    size_t count;
+};
+
+static struct node *nodes;
+static size_t node_count;
+static size_t routers;
+static int64_t gateway_back;
+
+// A time between low and high ms, on a simulation step
+static int64_t random_time(int low, int high)
+{
+    return (low + rand() % (high - low + 1)) / STEP_MS * STEP_MS;
+}
+
+static bool delivered(void)
+{
+    return rand() % 100 >= LOSS_PERCENT;
+}
+
+static void network(unsigned int seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < node_count; i++) {
+        struct node *node = &nodes[i];
+
+        node->detach = random_time(0, 5000);
+        node->attach = random_time(15000, 75000);
+        node->promote = i < routers ? node->attach + random_time(30000, 120000) : -1;
+        node->poll_phase = random_time(0, POLL_INTERVAL_MS - 1);
+    }
+}
+
+// SEARCHGW from a node. If the gateway answers, and both messages get
+// through, the node connects.
+static bool search(struct result *result, int64_t now)
+{
+    result->searches++;
+    result->per_second[now / 1000]++;
+
+    return now >= gateway_back && delivered() && delivered();
+}
+
+// CONNECT, with retransmissions, to a gateway that is up or not. Returns
+// when the outcome is known.
+static int64_t connect_gateway(int64_t now, bool *outcome)
+{
+    for (int i = 0; i <= RETRANSMISSION_COUNT; i++) {
+        int64_t sent = now + i * RETRANSMISSION_TIMEOUT_MS;
+
+        if (sent >= gateway_back && delivered() && delivered()) {
+            *outcome = true;
+            return sent + ROUND_TRIP_MS;
+        }
+    }
+    *outcome = false;
+    return now + CONNECT_TIMEOUT_MS;
+}
+
+// mqttsnScheduleSearch()
+static void schedule(struct node *node, int64_t now)
+{
+    node->next = now + backoff_delay_ms(SEARCH_BACKOFF_MIN_MS, SEARCH_BACKOFF_MAX_MS, node->attempts, rand());
+    if (node->attempts < UINT8_MAX) {
+        node->attempts++;
+    }
+    node->state = WAITING;
+}
+
+static void step_backoff(struct node *node, struct result *result, int64_t now)
+{
+    // mqttsnNetworkChanged(), only the first attach starts a search
+    if (now == node->detach) {
+        node->attached = false;
+        node->state = DETACHED;
+        node->attempts = 0;
+    }
+    if (now == node->attach) {
+        node->attached = true;
+        schedule(node, now);
+    }
+
+    if (node->state == WAITING && now >= node->next) {
+        if (node->cached && node->attempts == 1) {
+            result->direct++;
+            node->next = connect_gateway(now, &node->outcome);
+            node->state = CONNECTING;
+        } else if (search(result, now)) {
+            node->next = connect_gateway(now + ROUND_TRIP_MS, &node->outcome);
+            node->state = CONNECTING;
+        } else {
+            node->misses += now >= gateway_back;
+            schedule(node, now);
+        }
+    } else if (node->state == CONNECTING && now >= node->next) {
+        if (node->outcome) {
+            node->state = CONNECTED;
+            node->connected = now;
+        } else {
+            // A cached gateway that does not answer is forgotten
+            node->misses += now >= gateway_back;
+            node->cached = false;
+            schedule(node, now);
+        }
+    }
+}
+
+static void step_polling(struct node *node, struct result *result, int64_t now)
+{
+    bool role_changed = false;
+
+    if (now == node->detach) {
+        node->attached = false;
+        node->state = DETACHED;
+    }
+    if (now == node->attach) {
+        node->attached = true;
+        node->state = WAITING;
+        role_changed = true;
+    }
+    if (now == node->promote) {
+        role_changed = true;
+    }
+
+    if (node->state == WAITING &&
+        (role_changed || (now - node->poll_phase) % POLL_INTERVAL_MS == 0) &&
+        search(result, now)) {
+        node->next = connect_gateway(now + ROUND_TRIP_MS, &node->outcome);
+        node->state = CONNECTING;
+    } else if (node->state == CONNECTING && now >= node->next) {
+        node->state = node->outcome ? CONNECTED : WAITING;
+        node->connected = now;
+    }
+}
+
+static void run(struct result *result, bool backoff, unsigned int seed)
+{
+    memset(result->per_second, 0, sizeof(result->per_second));
+    result->searches = 0;
+    result->direct = 0;
+    result->count = 0;
+
+    network(seed);
+    for (size_t i = 0; i < node_count; i++) {
+        nodes[i].state = CONNECTED;
+        nodes[i].attached = true;
+        nodes[i].cached = true;
+        nodes[i].attempts = 0;
+        nodes[i].misses = 0;
+    }
+
+    srand(seed + 1);
+    for (int64_t now = 0; now < DURATION_MS; now += STEP_MS) {
+        for (size_t i = 0; i < node_count; i++) {
+            if (backoff) {
+                step_backoff(&nodes[i], result, now);
+            } else {
+                step_polling(&nodes[i], result, now);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < node_count; i++) {
+        const struct node *node = &nodes[i];
+
+        if (node->state != CONNECTED) {
+            continue;
+        }
+        result->connected[result->count++] = node->connected - gateway_back;
+
+        // Once the gateway is back a node searches within a backoff window,
+        // and each search or connect lost on the way costs another
+        if (backoff && node->connected - gateway_back >
+            (node->misses + 1) * (int64_t)SEARCH_BACKOFF_MAX_MS + CONNECT_TIMEOUT_MS + ROUND_TRIP_MS) {
+            fprintf(stderr, "node %zu connected %lld ms after the gateway, %u misses\n", i,
+                    (long long)(node->connected - gateway_back), node->misses);
+            check_failures++;
+        }
+    }
+}
+
+static int compare(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint32_t peak(const struct result *result, int seconds)
+{
+    uint32_t best = 0;
+
+    for (int start = 0; start + seconds <= SECONDS; start++) {
+        uint32_t sum = 0;
+
+        for (int i = 0; i < seconds; i++) {
+            sum += result->per_second[start + i];
+        }
+        best = MAX(best, sum);
+    }
+    return best;
+}
+
+static void report(const char *name, struct result *result)
+{
+    qsort(result->connected, result->count, sizeof(result->connected[0]), compare);
+
+    int64_t p50 = result->count ? result->connected[result->count / 2] : -1;
+    int64_t p95 = result->count ? result->connected[result->count * 95 / 100] : -1;
+    int64_t max = result->count ? result->connected[result->count - 1] : -1;
+
+    printf("%-8s %9u %9u %9u %10u %12u %9zu %8.1f %8.1f %8.1f\n", name, result->searches, peak(result, 1),
+           peak(result, 10), result->searches * (uint32_t)routers, peak(result, 1) * (uint32_t)routers,
+           result->count, p50 / 1e3, p95 / 1e3, max / 1e3);
+}
+
+int main(int argc, char **argv)
+{
+    node_count = argc > 1 ? atoi(argv[1]) : 300;
+    gateway_back = (argc > 2 ? atoi(argv[2]) : 180) * 1000LL;
+    unsigned int seed = argc > 3 ? atoi(argv[3]) : 11;
+    routers = MIN(node_count, MAX_ROUTERS);
+    struct result polling, backoff;
+
+    nodes = calloc(node_count, sizeof(nodes[0]));
+    polling.connected = calloc(node_count, sizeof(int64_t));
+    backoff.connected = calloc(node_count, sizeof(int64_t));
+    if (!nodes || !polling.connected || !backoff.connected || gateway_back >= DURATION_MS) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%zu nodes, %zu routers, gateway back after %lld s, %d%% loss\n", node_count, routers,
+           (long long)(gateway_back / 1000), LOSS_PERCENT);
+    printf("%-8s %9s %9s %9s %10s %12s %9s %8s %8s %8s\n", "client", "SEARCHGW", "peak/1s", "peak/10s",
+           "frames", "frames/1s", "connected", "p50 s", "p95 s", "max s");
+
+    run(&polling, false, seed);
+    report("polling", &polling);
+    run(&backoff, true, seed);
+    report("backoff", &backoff);
+
+    // Every node gets back, and the search costs the mesh less for it
+    CHECK_EQ(polling.count, node_count);
+    CHECK_EQ(backoff.count, node_count);
+    CHECK(backoff.searches < polling.searches);
+    CHECK(peak(&backoff, 1) < peak(&polling, 1));
+    CHECK(peak(&backoff, 10) < peak(&polling, 10));
+
+    free(nodes);
+    free(polling.connected);
+    free(backoff.connected);
+    return check_result();
+}
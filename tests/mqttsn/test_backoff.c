@@ -0,0 +1,59 @@
+/*
+ * Gateway search backoff tests: the delay stays in the upper half of a
+ * window that doubles from the minimum up to the maximum, and never
+ * overflows however many attempts went unanswered.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zephyr/sys/util.h>
+
+#include "backoff.h"
+#include "check.h"
+
+static void test_window(uint32_t min_ms, uint32_t max_ms)
+{
+    uint32_t window = min_ms;
+
+    for (unsigned int attempts = 0; attempts <= UINT8_MAX; attempts++) {
+        uint32_t low = UINT32_MAX, high = 0;
+
+        for (int i = 0; i < 2000; i++) {
+            uint32_t delay = backoff_delay_ms(min_ms, max_ms, attempts, rand());
+
+            low = MIN(low, delay);
+            high = MAX(high, delay);
+        }
+        CHECK(low >= window / 2);
+        CHECK(high <= window);
+
+        // The extremes of the window are reached
+        CHECK_EQ(backoff_delay_ms(min_ms, max_ms, attempts, 0), window / 2);
+        CHECK_EQ(backoff_delay_ms(min_ms, max_ms, attempts, window / 2), window);
+
+        window = MIN((uint64_t)window * 2, max_ms);
+    }
+}
+
+int main(void)
+{
+    srand(11);
+
+    // The Kconfig defaults and range limits
+    test_window(2 * 1000, 300 * 1000);
+    test_window(1000, 1000);
+    test_window(1000, 86400 * 1000);
+    test_window(3600 * 1000, 86400 * 1000);
+
+    // A maximum that is not a power of two times the minimum
+    test_window(3000, 10000);
+
+    // The window at the first attempt, and capped from the eighth on
+    CHECK_EQ(backoff_delay_ms(2000, 300000, 0, UINT32_MAX), 1000 + UINT32_MAX % 1001);
+    CHECK_EQ(backoff_delay_ms(2000, 300000, 8, 150000), 300000);
+    CHECK_EQ(backoff_delay_ms(2000, 300000, UINT8_MAX, 150000), 300000);
+
+    return check_result();
+}
@@ -0,0 +1,107 @@
+/*
+ * Encoding time and payload size per sample of each payload encoder, for
+ * batches of 1, 4 and 16 samples of a node that mostly stands still.
+ *
+ * Usage: bench_telemetry_encode [passes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "bench.h"
+#include "check.h"
+#include "telemetry_encode.h"
+
+#define SAMPLES 1024
+#define NOW (5000 * 1000LL)
+
+static struct telemetry_sample samples[SAMPLES];
+
+// A walk that moves now and then, as CONFIG_TELEMETRY_ADAPTIVE would buffer
+static void walk(void)
+{
+    struct telemetry_sample sample = {
+        .position = { .valid = true, .latitude = 515074000, .longitude = -1278000, .elevation = 35000 },
+        .temperature = 2150,
+        .rloc16 = 0x5c01,
+        .role = 3,
+        .battery = 90,
+    };
+
+    srand(21);
+    for (int i = 0; i < SAMPLES; i++) {
+        if (rand() % 4 == 0) {
+            sample.position.latitude += rand() % 2001 - 1000;
+            sample.position.longitude += rand() % 2001 - 1000;
+            sample.position.speed = rand() % 300;
+        }
+        if (rand() % 8 == 0) {
+            sample.temperature += rand() % 21 - 10;
+        }
+        sample.seq = i;
+        sample.timestamp = NOW - (SAMPLES - i) * 1000LL;
+        samples[i] = sample;
+    }
+}
+
+// Seconds to encode every sample passes times in batches of count, with
+// the payload bytes in *bytes
+static double run(const struct telemetry_encoder *encoder, size_t count, long passes,
+                  uint64_t *cycles, size_t *bytes)
+{
+    static uint8_t data[TELEMETRY_JSON_SIZE(16)];
+    struct delta_state acked = { 0 };
+    struct delta_state delta;
+    struct telemetry_encode_context ctx = {
+        .now = NOW,
+        .id = "f4ce361832e86d55",
+        .delta = &delta,
+        .ages = true,
+    };
+    struct bench bench;
+
+    *bytes = 0;
+    bench_start(&bench);
+    for (long pass = 0; pass < passes; pass++) {
+        for (size_t first = 0; first + count <= SAMPLES; first += count) {
+            // Encoded against the acknowledged state, as the MQTT-SN client does
+            delta = acked;
+            *bytes += encoder->encode(&ctx, &samples[first], count, data, sizeof(data));
+            acked = delta;
+            bench_use(data);
+        }
+    }
+    return bench_stop(&bench, cycles);
+}
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 20000;
+    const struct telemetry_encoder *encoders[] = {
+        &telemetry_encoder_json,
+        &telemetry_encoder_binary,
+        &telemetry_encoder_delta,
+    };
+    const size_t counts[] = { 1, 4, 16 };
+
+    walk();
+
+    printf("%-8s %6s %12s %12s %14s\n", "encoder", "batch", "ns/sample", "cycles", "bytes/sample");
+    for (size_t e = 0; e < ARRAY_SIZE(encoders); e++) {
+        for (size_t c = 0; c < ARRAY_SIZE(counts); c++) {
+            uint64_t cycles;
+            size_t bytes;
+            double seconds = run(encoders[e], counts[c], passes, &cycles, &bytes);
+            double encoded = (double)passes * (SAMPLES - SAMPLES % counts[c]);
+
+            CHECK(bytes > 0);
+            printf("%-8s %6zu %12.1f %12.0f %14.1f\n", encoders[e]->name, counts[c],
+                   seconds * 1e9 / encoded, cycles / encoded, bytes / encoded);
+        }
+    }
+
+    return check_result();
+}
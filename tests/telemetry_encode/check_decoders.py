@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+#
+# Decode the batches printed by "test_telemetry_encode vectors", each in
+# JSON, binary and delta with ages, with scripts/decode_mqttsn.py and check
+# that all three give the same samples.
+#
+# Usage:
+#   check_decoders.py <test_telemetry_encode> <scripts directory>
+#
+
+import json
+import subprocess
+import sys
+
+sys.path.insert(0, sys.argv[2])
+import decode_mqttsn  # noqa: E402
+
+TOPIC = "ot/f4ce361832e86d55"
+HEADER = ["RLOC16", "Version", "Count", "Role", "Status", "Battery"]
+SAMPLE = ["Age", "GPSLock", "Latitude", "Longitude", "Elevation", "Speed", "Temperature"]
+
+
+def compare(batch, name, expected, actual, keys):
+    differences = 0
+    for key in keys:
+        if expected[key] != actual.get(key):
+            print("batch %d %s: %s is %r, JSON has %r" % (batch, name, key, actual.get(key), expected[key]))
+            differences += 1
+    return differences
+
+
+def main():
+    output = subprocess.run([sys.argv[1], "vectors"], check=True, capture_output=True, text=True).stdout
+    lines = output.splitlines()
+    differences = 0
+
+    for batch in range(len(lines) // 3):
+        text = lines[3 * batch].split(" ", 1)[1]
+        binary = bytes.fromhex(lines[3 * batch + 1].split()[1])
+        delta = bytes.fromhex(lines[3 * batch + 2].split()[1])
+
+        expected = json.loads(text)
+        decoded = decode_mqttsn.decode(binary, TOPIC)
+        deltas = decode_mqttsn.decode_delta(delta, TOPIC)
+
+        differences += compare(batch, "binary", expected, decoded, ["ID"] + HEADER)
+        if len(decoded["Samples"]) != len(expected["Samples"]) or len(deltas["Samples"]) != len(expected["Samples"]):
+            print("batch %d: sample counts differ" % batch)
+            differences += 1
+            continue
+
+        for i, sample in enumerate(expected["Samples"]):
+            differences += compare(batch, "binary sample %d" % i, sample, decoded["Samples"][i], SAMPLE)
+            differences += compare(batch, "delta sample %d" % i, sample, deltas["Samples"][i], SAMPLE)
+
+            # Delta records carry the header fields per sample, and the
+            # JSON header holds those of the newest
+            if deltas["Samples"][i]["Count"] != (expected["Count"] + i) & 0xFFFF:
+                print("batch %d delta sample %d: Count is %r" % (batch, i, deltas["Samples"][i]["Count"]))
+                differences += 1
+        differences += compare(batch, "delta newest", expected, deltas["Samples"][-1],
+                               ["RLOC16", "Role", "Status", "Battery"])
+
+    print("%d batches decoded, %d differences" % (len(lines) // 3, differences))
+    return 1 if differences or not lines else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,260 @@
+/*
+ * Payload encoder tests.
+ *
+ * With "vectors" as its argument, batches of random samples are printed
+ * instead, each encoded by every encoder, for check_decoders.py to check
+ * that scripts/decode_mqttsn.py decodes all of them to the same samples.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "app.h"
+#include "check.h"
+#include "telemetry_encode.h"
+
+#define MAX_SAMPLES 16
+#define NOW (200000 * 1000LL)
+
+static const struct telemetry_sample two_samples[] = {
+    {
+        .seq = 0x0102,
+        .timestamp = NOW - 61 * 1000 - 999,     // 61 s old, rounded down
+        .position = {
+            .valid = true,
+            .latitude = 515074000,
+            .longitude = -1278000,
+            .elevation = 35499,
+            .speed = 140,
+        },
+        .temperature = 2150,
+        .rloc16 = 0x5c00,
+        .role = 2,
+        .triage = 0,
+        .battery = 90,
+    },
+    {
+        .seq = 0x0103,
+        .timestamp = NOW,
+        .position = { .valid = false },
+        .temperature = -705,
+        .rloc16 = 0x5c01,
+        .role = 3,
+        .triage = 2,
+        .battery = 87,
+    },
+};
+
+// Every field at its widest when printed
+static void widest_samples(struct telemetry_sample *samples, size_t count, int64_t now)
+{
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = (struct telemetry_sample){
+            .seq = UINT16_MAX,
+            .timestamp = now - 100000 * 1000LL,
+            .position = {
+                .valid = true,
+                .latitude = INT32_MIN,
+                .longitude = INT32_MIN,
+                .elevation = INT32_MIN,
+                .speed = INT32_MIN,
+            },
+            .temperature = INT32_MIN,
+            .rloc16 = UINT16_MAX,
+            .role = 0,                  // "disabled", the longest role name
+            .triage = UINT8_MAX,
+            .battery = UINT8_MAX,
+        };
+    }
+}
+
+static void test_json_worst_case(void)
+{
+    static struct telemetry_sample samples[MAX_SAMPLES];
+    static uint8_t data[TELEMETRY_JSON_SIZE(MAX_SAMPLES)];
+    char id[TELEMETRY_JSON_ID_LENGTH + 1];
+    struct telemetry_encode_context ctx = { .now = 200000 * 1000LL, .id = id };
+
+    memset(id, 'f', TELEMETRY_JSON_ID_LENGTH);
+    id[TELEMETRY_JSON_ID_LENGTH] = '\0';
+    widest_samples(samples, MAX_SAMPLES, ctx.now);
+
+    for (size_t count = 1; count <= MAX_SAMPLES; count++) {
+        size_t size = TELEMETRY_JSON_SIZE(count);
+        size_t length = telemetry_encoder_json.encode(&ctx, samples, count, data, size);
+
+        // Fits, NUL included, and is a whole object
+        CHECK(length > 0 && length < size);
+        CHECK_EQ(strlen((char *)data), length);
+        CHECK(length > 3 && memcmp(&data[length - 3], "] }", 3) == 0);
+
+        // One byte short is reported as not fitting rather than cut short
+        CHECK_EQ(telemetry_encoder_json.encode(&ctx, samples, count, data, length), 0);
+    }
+}
+
+static void test_json_layout(void)
+{
+    struct telemetry_encode_context ctx = { .now = NOW, .id = "f4ce361832e86d55" };
+    uint8_t data[TELEMETRY_JSON_SIZE(2)];
+    const char *expected =
+        "{\"ID\":\"f4ce361832e86d55\", \"RLOC16\":\"5C01\", \"Version\":\"" STRINGIFY(VERSION) "\", "
+        "\"Count\":258, \"Role\":\"router\", \"Status\":\"P2\", \"Battery\":87, \"Samples\":["
+        "{\"Age\":61, \"GPSLock\": 1, \"Latitude\":515074000, \"Longitude\":-1278000, "
+        "\"Elevation\":35, \"Speed\":140, \"Temperature\":21.50}, "
+        "{\"Age\":0, \"GPSLock\": 0, \"Latitude\":0, \"Longitude\":0, "
+        "\"Elevation\":0, \"Speed\":0, \"Temperature\":-7.05}] }";
+
+    size_t length = telemetry_encoder_json.encode(&ctx, two_samples, 2, data, sizeof(data));
+    CHECK_EQ(length, strlen(expected));
+    CHECK(strcmp((char *)data, expected) == 0);
+}
+
+static void test_binary_layout(void)
+{
+    struct telemetry_encode_context ctx = { .now = NOW };
+    uint8_t data[TELEMETRY_BINARY_SIZE(2)];
+    const uint8_t expected[] = {
+        VERSION, 0x02, 0x01, 0x01, 0x5c, 0x03, 0x02, 87, 2,
+        // Age, flags, latitude, longitude, elevation, speed, temperature
+        61, 0x00, 0x01,
+        0xd0, 0x67, 0xb3, 0x1e, 0xd0, 0x7f, 0xec, 0xff,
+        0x23, 0x00, 0x8c, 0x00, 0x66, 0x08,
+        0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x3f, 0xfd,
+    };
+
+    CHECK_EQ(telemetry_encoder_binary.encode(&ctx, two_samples, 2, data, sizeof(data)), sizeof(expected));
+    CHECK(memcmp(data, expected, sizeof(expected)) == 0);
+
+    CHECK_EQ(telemetry_encoder_binary.encode(&ctx, two_samples, 2, data, sizeof(data) - 1), 0);
+}
+
+static void test_delta_ages(void)
+{
+    struct delta_state state = { 0 };
+    struct telemetry_encode_context ctx = { .now = NOW, .delta = &state, .ages = true };
+    uint8_t data[TELEMETRY_DELTA_SIZE(2)];
+
+    // Each record preceded by its age, the first a keyframe and the second
+    // only what changed: status, battery, RLOC16, flags, position,
+    // elevation, speed and temperature all differ, so everything again
+    size_t length = telemetry_encoder_delta.encode(&ctx, two_samples, 2, data, sizeof(data));
+    CHECK_EQ(length, 2 * (2 + DELTA_MAX_SIZE));
+    CHECK_EQ(data[0], 61);
+    CHECK_EQ(data[1], 0);
+    CHECK_EQ(data[2], VERSION | DELTA_KEYFRAME);
+    CHECK_EQ(data[2 + DELTA_MAX_SIZE], 0);
+    CHECK_EQ(data[2 + DELTA_MAX_SIZE + 2], VERSION);
+    CHECK_EQ(data[2 + DELTA_MAX_SIZE + 2 + 3], 0xff);
+
+    // The same sample again is a bare header after its age
+    struct telemetry_sample again = two_samples[1];
+    again.seq++;
+    CHECK_EQ(telemetry_encoder_delta.encode(&ctx, &again, 1, data, sizeof(data)), 2 + DELTA_HEADER_SIZE);
+
+    // Without ages, bare records
+    ctx.ages = false;
+    again.seq++;
+    CHECK_EQ(telemetry_encoder_delta.encode(&ctx, &again, 1, data, sizeof(data)), DELTA_HEADER_SIZE);
+
+    // Too small for the worst case of the batch
+    struct delta_state before = state;
+    ctx.ages = true;
+    CHECK_EQ(telemetry_encoder_delta.encode(&ctx, two_samples, 1, data, 2 + DELTA_MAX_SIZE - 1), 0);
+    CHECK(memcmp(&state, &before, sizeof(state)) == 0);
+}
+
+static void test_age_saturation(void)
+{
+    struct telemetry_encode_context ctx = { .now = NOW };
+    struct telemetry_sample old = two_samples[0];
+    uint8_t data[TELEMETRY_BINARY_SIZE(1)];
+
+    old.timestamp = NOW - 100000 * 1000LL;
+    telemetry_encoder_binary.encode(&ctx, &old, 1, data, sizeof(data));
+    CHECK_EQ(data[TELEMETRY_BINARY_HEADER_SIZE], 0xff);
+    CHECK_EQ(data[TELEMETRY_BINARY_HEADER_SIZE + 1], 0xff);
+}
+
+static void random_sample(struct telemetry_sample *sample, uint16_t seq)
+{
+    *sample = (struct telemetry_sample){
+        .seq = seq,
+        .timestamp = NOW - (rand() % 4000) * 1000LL,
+        .position = {
+            .valid = rand() % 2,
+            .latitude = rand() % 1800000001 - 900000000,
+            .longitude = rand() % 2000000001 - 1000000000,
+            .elevation = rand() % 2000001 - 100000,
+            .speed = rand() % 5000,
+        },
+        .temperature = rand() % 10001 - 4000,
+        .rloc16 = rand(),
+        .role = rand() % 5,
+        .triage = rand() % 4,
+        .battery = rand() % 101,
+    };
+}
+
+static void print_hex(const char *name, const uint8_t *data, size_t length)
+{
+    printf("%s ", name);
+    for (size_t i = 0; i < length; i++) {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+}
+
+// One line per encoder per batch, "<encoder> <payload>", JSON as text
+static void print_vectors(void)
+{
+    static struct telemetry_sample samples[MAX_SAMPLES];
+    static uint8_t data[TELEMETRY_JSON_SIZE(MAX_SAMPLES)];
+    struct delta_state state = { 0 };
+    struct telemetry_encode_context ctx = {
+        .now = NOW,
+        .id = "f4ce361832e86d55",
+        .delta = &state,
+        .ages = true,
+    };
+    uint16_t seq = 0;
+
+    srand(21);
+
+    for (int batch = 0; batch < 500; batch++) {
+        size_t count = 1 + rand() % MAX_SAMPLES;
+
+        for (size_t i = 0; i < count; i++) {
+            random_sample(&samples[i], seq++);
+        }
+
+        size_t length = telemetry_encoder_json.encode(&ctx, samples, count, data, sizeof(data));
+        printf("json %s\n", (char *)data);
+        length = telemetry_encoder_binary.encode(&ctx, samples, count, data, sizeof(data));
+        print_hex("binary", data, length);
+        length = telemetry_encoder_delta.encode(&ctx, samples, count, data, sizeof(data));
+        print_hex("delta", data, length);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && !strcmp(argv[1], "vectors")) {
+        print_vectors();
+        return EXIT_SUCCESS;
+    }
+
+    test_json_worst_case();
+    test_json_layout();
+    test_binary_layout();
+    test_delta_ages();
+    test_age_saturation();
+
+    return check_result();
+}